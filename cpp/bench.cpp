@@ -0,0 +1,563 @@
+#include "boundary.h"
+#include "input.h"
+#include "isohedral.h"
+#include "letter_kernels.h"
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Microbenchmarks for boundary extraction and the isohedral checker on
+// synthetic polyforms. Every benchmark is reported per boundary length,
+// in ns per word and words per second.
+
+struct Options {
+  // Minimum time spent on one measurement, in seconds.
+  double minTime = 0.05;
+  uint32_t seed = 1;
+  // Random polyforms generated per size.
+  int wordsPerSize = 100;
+  // Largest boundary word generated. The checker's factor arrays are
+  // sized for words of up to MAX_BND letters.
+  int maxLength = 40;
+  // Only benchmarks whose name contains this are run.
+  string filter;
+  bool json = false;
+};
+
+struct Result {
+  string benchmark;
+  string grid;
+  string family;
+  int length;
+  size_t words;
+  double nsPerWord;
+};
+
+// Words of one grid and family, grouped by boundary length.
+struct WordSet {
+  string grid;
+  string family;
+  GridType gridType;
+  map<int, vector<boundaryword>> byLength;
+  // 1 if every word is known to tile isohedrally, 0 if none does, -1 if
+  // unknown.
+  int expected = -1;
+};
+
+// Keeps results alive so the compiler can't drop the measured calls.
+volatile size_t sink = 0;
+
+double secondsSince(chrono::steady_clock::time_point start) {
+  return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// Runs body, which handles items words, until minTime has passed. Returns
+// ns per word.
+double timePerWord(size_t items, double minTime, const function<void()>& body) {
+  body();
+  size_t reps = 0;
+  auto start = chrono::steady_clock::now();
+  double elapsed;
+  do {
+    body();
+    ++reps;
+    elapsed = secondsSince(start);
+  } while (elapsed < minTime);
+  return elapsed * 1e9 / (double(reps) * items);
+}
+
+// Times fn on one word, repeating it until the clock reading is
+// meaningful. Returns ns per call.
+double timeOne(const function<size_t()>& fn) {
+  sink = sink + fn();
+  for (size_t reps = 1;; reps *= 2) {
+    auto start = chrono::steady_clock::now();
+    for (size_t r = 0; r < reps; ++r) {
+      sink = sink + fn();
+    }
+    double elapsed = secondsSince(start);
+    if (elapsed > 2e-6 || reps >= (1 << 20)) {
+      return elapsed * 1e9 / reps;
+    }
+  }
+}
+
+// Grows a random polyform of the given size from a cell at the origin,
+// retrying until its boundary is a simple closed curve.
+template <typename grid>
+Shape<grid> randomPolyform(int size, mt19937& rng) {
+  using point_t = typename grid::point_t;
+  while (true) {
+    vector<point_t> cells = {grid::origins[0]};
+    set<point_t> seen(cells.begin(), cells.end());
+    while ((int)cells.size() < size) {
+      point_t c = cells[rng() % cells.size()];
+      const point<int8_t>* vectors = grid::getEdgeNeighbourVectors(c);
+      point_t q = c + point_t(vectors[rng() % grid::numEdgeNeighbours(c)]);
+      if (seen.insert(q).second) {
+        cells.push_back(q);
+      }
+    }
+    Shape<grid> shape;
+    for (auto& c: cells) {
+      shape.add(c);
+    }
+    if (hasSimpleBoundary(shape)) {
+      return shape;
+    }
+  }
+}
+
+// A 1 x k bar, which tiles by translation.
+Shape<OminoGrid<int>> ominoBar(int k) {
+  Shape<OminoGrid<int>> shape;
+  for (int i = 0; i < k; ++i) {
+    shape.add(i, 0);
+  }
+  return shape;
+}
+
+// A bar of k cells with one more cell on top of its first. Two copies
+// make a 2 x (k + 1) rectangle, so it tiles with half turns.
+Shape<OminoGrid<int>> ominoL(int k) {
+  Shape<OminoGrid<int>> shape = ominoBar(k);
+  shape.add(0, 1);
+  return shape;
+}
+
+// A staircase of k steps, each two cells wide, which tiles by
+// translation along (2, 0) and (k, k).
+Shape<OminoGrid<int>> ominoStair(int k) {
+  Shape<OminoGrid<int>> shape;
+  for (int i = 0; i < k; ++i) {
+    shape.add(i, i);
+    shape.add(i + 1, i);
+  }
+  return shape;
+}
+
+// The three heptominoes without holes that don't tile the plane at all.
+vector<Shape<OminoGrid<int>>> nonTilingHeptominoes() {
+  const vector<vector<pair<int, int>>> cells = {
+    {{0, 0}, {0, 1}, {0, 2}, {0, 3}, {0, 4}, {1, 0}, {1, 4}},
+    {{0, 0}, {0, 1}, {0, 2}, {1, 2}, {1, 3}, {2, 2}, {3, 2}},
+    {{0, 1}, {1, 0}, {1, 1}, {1, 2}, {1, 3}, {2, 1}, {3, 1}},
+  };
+  vector<Shape<OminoGrid<int>>> shapes;
+  for (auto& heptomino: cells) {
+    shapes.emplace_back();
+    for (auto& c: heptomino) {
+      shapes.back().add(c.first, c.second);
+    }
+  }
+  return shapes;
+}
+
+// A square spiral path of k cells with one empty row between turns. Its
+// long, nearly periodic boundary makes the factor searches run long.
+Shape<OminoGrid<int>> ominoSpiral(int k) {
+  const int dx[4] = {1, 0, -1, 0};
+  const int dy[4] = {0, 1, 0, -1};
+  Shape<OminoGrid<int>> shape;
+  int x = 0, y = 0;
+  shape.add(x, y);
+  for (int arm = 0, dir = 0; (int)shape.size() < k; ++arm, dir = (dir + 1) % 4) {
+    int armLength = 2 * (arm / 2 + 1);
+    for (int s = 0; s < armLength && (int)shape.size() < k; ++s) {
+      x += dx[dir];
+      y += dy[dir];
+      shape.add(x, y);
+    }
+  }
+  return shape;
+}
+
+// A spine of k cells with a tooth of height 2 on every other cell.
+Shape<OminoGrid<int>> ominoComb(int k) {
+  Shape<OminoGrid<int>> shape;
+  for (int i = 0; i < k; ++i) {
+    shape.add(i, 0);
+    if (i % 2 == 0) {
+      shape.add(i, 1);
+      shape.add(i, 2);
+    }
+  }
+  return shape;
+}
+
+// Returns whether every generated shape has a simple boundary, and names
+// the first one that doesn't. A boundary word of any other shape is
+// meaningless to the checker.
+template <typename grid>
+bool allSimple(const string& family, const vector<Shape<grid>>& shapes) {
+  for (size_t i = 0; i < shapes.size(); ++i) {
+    if (!hasSimpleBoundary(shapes[i])) {
+      cerr << "Error: " << family << " shape " << i << " has no simple boundary\n";
+      return false;
+    }
+  }
+  return true;
+}
+
+void report(vector<Result>& results, const string& benchmark, const WordSet& set, int length,
+            size_t words, double nsPerWord) {
+  results.push_back({benchmark, set.grid, set.family, length, words, nsPerWord});
+}
+
+// Builds a word set from shapes and benchmarks getBoundaryWord on them.
+template <typename grid>
+WordSet traceShapes(const string& gridName, const string& family, const vector<Shape<grid>>& shapes,
+                    const Options& options, vector<Result>& results) {
+  WordSet set{gridName, family, grid::grid_type, {}};
+  map<int, vector<const Shape<grid>*>> shapesByLength;
+  for (auto& shape: shapes) {
+    boundaryword word = getBoundaryWord(shape);
+    if ((int)word.size() <= options.maxLength) {
+      set.byLength[word.size()].push_back(word);
+      shapesByLength[word.size()].push_back(&shape);
+    }
+  }
+  if (string("boundary").find(options.filter) != string::npos) {
+    for (auto& group: shapesByLength) {
+      const vector<const Shape<grid>*>& group_shapes = group.second;
+      double ns = timePerWord(group_shapes.size(), options.minTime, [&]() {
+        for (auto* shape: group_shapes) {
+          sink = sink + getBoundaryWord(*shape).size();
+        }
+      });
+      report(results, "boundary", set, group.first, group_shapes.size(), ns);
+    }
+  }
+  return set;
+}
+
+template <typename grid>
+WordSet randomWords(const string& gridName, const Options& options, mt19937& rng,
+                    vector<Result>& results) {
+  vector<Shape<grid>> shapes;
+  for (int size = 2; size <= options.maxLength / 2; ++size) {
+    for (int i = 0; i < options.wordsPerSize; ++i) {
+      shapes.push_back(randomPolyform<grid>(size, rng));
+    }
+  }
+  return traceShapes<grid>(gridName, "random", shapes, options, results);
+}
+
+template <typename T, size_t N>
+vector<T> toVector(const PartialArray<T, N>& array) {
+  return vector<T>(array.begin(), array.end());
+}
+
+// The admissible factors of one word, kept compactly so that whole word
+// sets fit in memory.
+struct Factors {
+  vector<FactorPair> mirrorFactorPairs;
+  vector<Factor> palinFactors;
+  vector<Factor> mirrorFactors;
+  vector<Factor> ninetyFactors;
+  vector<Factor> reflectSquareFactors;
+  vector<Factor> onetwentyFactors;
+  vector<Factor> sixtyFactors;
+};
+
+// Checks the words of a set with a known result through both checker
+// entry points. Returns the number of wrong results.
+size_t verifyKnown(const WordSet& set) {
+  if (set.expected < 0) {
+    return 0;
+  }
+  IsohedralChecker checker = IsohedralChecker::forGrid(set.gridType);
+  size_t wrong = 0;
+  for (auto& group: set.byLength) {
+    vector<bool> batch = checker.check_batch(group.second);
+    for (size_t w = 0; w < group.second.size(); ++w) {
+      bool single = checker.has_isohedral_tiling(group.second[w]);
+      if (single != bool(set.expected) || batch[w] != bool(set.expected)) {
+        cerr << "Error: " << set.grid << " " << set.family << " word " << w << " of length "
+             << group.first << " should " << (set.expected ? "" : "not ") << "tile isohedrally\n";
+        ++wrong;
+      }
+    }
+  }
+  return wrong;
+}
+
+void benchmarkChecker(const WordSet& set, const Options& options, vector<Result>& results) {
+  IsohedralChecker checker = IsohedralChecker::forGrid(set.gridType);
+  auto wanted = [&](const string& name) {
+    return name.find(options.filter) != string::npos;
+  };
+
+  for (auto& group: set.byLength) {
+    int length = group.first;
+    const vector<boundaryword>& words = group.second;
+    vector<TransformBank> banks;
+    for (auto& P: words) {
+      banks.push_back(checker.transform_bank(P));
+    }
+
+    // Routines timed over the whole group.
+    auto timeGroup = [&](const string& name, const function<size_t(size_t)>& fn) {
+      if (!wanted(name)) {
+        return;
+      }
+      double ns = timePerWord(words.size(), options.minTime, [&]() {
+        for (size_t w = 0; w < words.size(); ++w) {
+          sink = sink + fn(w);
+        }
+      });
+      report(results, name, set, length, words.size(), ns);
+    };
+    timeGroup("transform_bank", [&](size_t w) { return checker.transform_bank(words[w]).n; });
+    timeGroup("mirror_factors", [&](size_t w) {
+      return checker.admissible_mirror_factors(banks[w]).filled_count;
+    });
+    timeGroup("gapped_mirror_factors", [&](size_t w) {
+      return checker.admissible_gapped_mirror_factor_pairs(banks[w]).filled_count;
+    });
+    for (int theta: {180, 90, 120, 60}) {
+      timeGroup("rotadrome_factors_" + to_string(theta), [&](size_t w) {
+        return checker.admissible_rotadrome_factors(banks[w], theta).filled_count;
+      });
+    }
+    timeGroup("reflect_square_factors", [&](size_t w) {
+      return checker.admissible_reflect_square_factors(banks[w]).filled_count;
+    });
+    timeGroup("gapped_reflect_square_factors", [&](size_t w) {
+      size_t count = 0;
+      for (auto& p: banks[w].reflected) {
+        count += checker.admissible_gapped_reflect_square_factor_pairs(banks[w], p.first).size();
+      }
+      return count;
+    });
+    timeGroup("has_isohedral_tiling", [&](size_t w) {
+      return size_t(checker.has_isohedral_tiling(words[w]));
+    });
+    if (wanted("check_batch")) {
+      double ns = timePerWord(words.size(), options.minTime, [&]() {
+        sink = sink + checker.check_batch(words).size();
+      });
+      report(results, "check_batch", set, length, words.size(), ns);
+    }
+
+    // Tiling cases, timed word by word since their inputs are too large
+    // to keep for a whole group.
+    vector<Factors> factors(words.size());
+    for (size_t w = 0; w < words.size(); ++w) {
+      factors[w].mirrorFactorPairs = toVector(checker.admissible_gapped_mirror_factor_pairs(banks[w]));
+      factors[w].palinFactors = toVector(checker.admissible_rotadrome_factors(banks[w], 180));
+      factors[w].mirrorFactors = toVector(checker.admissible_mirror_factors(banks[w]));
+      factors[w].ninetyFactors = toVector(checker.admissible_rotadrome_factors(banks[w], 90));
+      factors[w].reflectSquareFactors = toVector(checker.admissible_reflect_square_factors(banks[w]));
+      factors[w].onetwentyFactors = toVector(checker.admissible_rotadrome_factors(banks[w], 120));
+      factors[w].sixtyFactors = toVector(checker.admissible_rotadrome_factors(banks[w], 60));
+    }
+    FactorPairArray<MAX_BND*MAX_BND> mirror_factor_pairs;
+    FactorArray<2*MAX_BND> palin_factors;
+    FactorArray<2*MAX_BND> mirror_factors;
+    FactorArray<2*MAX_BND> ninety_factors;
+    FactorArray<MAX_BND*MAX_BND> reflect_square_factors;
+    FactorArray<2*MAX_BND> onetwenty_factors;
+    FactorArray<2*MAX_BND> sixty_factors;
+    auto timeCase = [&](const string& name, const function<bool(size_t)>& fn) {
+      if (!wanted(name)) {
+        return;
+      }
+      double total = 0;
+      for (size_t w = 0; w < words.size(); ++w) {
+        const Factors& f = factors[w];
+        fill_partial(mirror_factor_pairs, f.mirrorFactorPairs);
+        fill_partial(palin_factors, f.palinFactors);
+        fill_partial(mirror_factors, f.mirrorFactors);
+        fill_partial(ninety_factors, f.ninetyFactors);
+        fill_partial(reflect_square_factors, f.reflectSquareFactors);
+        fill_partial(onetwenty_factors, f.onetwentyFactors);
+        fill_partial(sixty_factors, f.sixtyFactors);
+        total += timeOne([&]() { return size_t(fn(w)); });
+      }
+      report(results, name, set, length, words.size(), total / words.size());
+    };
+    timeCase("translation", [&](size_t w) {
+      return checker.has_translation_tiling(words[w], mirror_factors);
+    });
+    timeCase("half_turn", [&](size_t w) {
+      return checker.has_half_turn_tiling(words[w], mirror_factor_pairs, palin_factors);
+    });
+    timeCase("quarter_turn", [&](size_t w) {
+      return checker.has_quarter_turn_tiling(words[w], ninety_factors, palin_factors);
+    });
+    timeCase("type_1_reflection", [&](size_t w) {
+      return checker.has_type_1_reflection_tiling(words[w], reflect_square_factors, mirror_factor_pairs);
+    });
+    timeCase("type_2_reflection", [&](size_t w) {
+      return checker.has_type_2_reflection_tiling(banks[w], mirror_factors);
+    });
+    timeCase("type_1_half_turn_reflection", [&](size_t w) {
+      return checker.has_type_1_half_turn_reflection_tiling(words[w], mirror_factor_pairs, palin_factors, reflect_square_factors);
+    });
+    timeCase("type_2_half_turn_reflection", [&](size_t w) {
+      return checker.has_type_2_half_turn_reflection_tiling(banks[w], palin_factors);
+    });
+    timeCase("case_7", [&](size_t w) {
+      return checker.has_case_7_tiling(words[w], onetwenty_factors);
+    });
+    timeCase("case_8a", [&](size_t w) {
+      return checker.has_case_8a_tiling(words[w], palin_factors, sixty_factors, onetwenty_factors);
+    });
+    timeCase("case_8b", [&](size_t w) {
+      return checker.has_case_8b_tiling(words[w], palin_factors, sixty_factors, onetwenty_factors);
+    });
+  }
+}
+
+void printTable(const vector<Result>& results) {
+  cout << left << setw(30) << "Benchmark" << setw(8) << "Grid" << setw(8) << "Family" << right
+       << setw(8) << "Length" << setw(8) << "Words" << setw(14) << "ns/word" << setw(14) << "words/s"
+       << "\n";
+  cout << fixed;
+  for (auto& r: results) {
+    cout << left << setw(30) << r.benchmark << setw(8) << r.grid << setw(8) << r.family << right
+         << setw(8) << r.length << setw(8) << r.words
+         << setw(14) << setprecision(1) << r.nsPerWord
+         << setw(14) << setprecision(0) << 1e9 / r.nsPerWord << "\n";
+  }
+}
+
+void printJson(const vector<Result>& results, const Options& options) {
+  cout << "{\"isa\": \"" << letter_kernels().name << "\", \"seed\": " << options.seed
+       << ", \"results\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    const Result& r = results[i];
+    cout << (i ? ",\n  " : "\n  ")
+         << "{\"benchmark\": \"" << r.benchmark << "\", \"grid\": \"" << r.grid
+         << "\", \"family\": \"" << r.family << "\", \"length\": " << r.length
+         << ", \"words\": " << r.words << ", \"ns_per_word\": " << r.nsPerWord
+         << ", \"words_per_s\": " << 1e9 / r.nsPerWord << "}";
+  }
+  cout << "\n]}\n";
+}
+
+void printUsage() {
+  cout << "Usage: ./bench [options]\n"
+       << "Options:\n"
+       << "  --json             print results as JSON\n"
+       << "  --filter=<text>    run only benchmarks whose name contains text\n"
+       << "  --min-time=<s>     minimum time per measurement (default 0.05)\n"
+       << "  --seed=<n>         seed of the random polyform generator (default 1)\n"
+       << "  --words=<n>        random polyforms per size (default 100)\n"
+       << "  --max-length=<n>   longest boundary word to generate (default 40)\n"
+       << "  --isa=<name>       letter kernels to use\n";
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  auto badValue = [](const std::string& arg) {
+    cerr << "Invalid option value: " << arg << "\n";
+    printUsage();
+    return -1;
+  };
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--json") {
+      options.json = true;
+    } else if (arg.rfind("--filter=", 0) == 0) {
+      options.filter = arg.substr(9);
+    } else if (arg.rfind("--min-time=", 0) == 0) {
+      if (!parse_number(arg.substr(11), options.minTime) || !(options.minTime > 0)) {
+        return badValue(arg);
+      }
+    } else if (arg.rfind("--seed=", 0) == 0) {
+      if (!parse_number(arg.substr(7), options.seed)) {
+        return badValue(arg);
+      }
+    } else if (arg.rfind("--words=", 0) == 0) {
+      if (!parse_number(arg.substr(8), options.wordsPerSize) || options.wordsPerSize < 1) {
+        return badValue(arg);
+      }
+    } else if (arg.rfind("--max-length=", 0) == 0) {
+      if (!parse_number(arg.substr(13), options.maxLength) || options.maxLength < 1) {
+        return badValue(arg);
+      }
+      options.maxLength = std::min(options.maxLength, MAX_BND);
+    } else if (arg.rfind("--isa=", 0) == 0) {
+      if (!select_letter_kernels(arg.substr(6))) {
+        cerr << "Unsupported instruction set: " << arg.substr(6) << "\n";
+        return -1;
+      }
+    } else {
+      printUsage();
+      return -1;
+    }
+  }
+
+  mt19937 rng(options.seed);
+  vector<Result> results;
+  vector<WordSet> sets;
+  sets.push_back(randomWords<OminoGrid<int>>("omino", options, rng, results));
+  sets.push_back(randomWords<HexGrid<int>>("hex", options, rng, results));
+  sets.push_back(randomWords<IamondGrid<int>>("iamond", options, rng, results));
+  sets.push_back(randomWords<KiteGrid<int>>("kite", options, rng, results));
+
+  // Structured polyominoes: bars, L shapes and staircases are known
+  // tilers and the non-tiling heptominoes known non-tilers, so the checker
+  // is verified on them; spirals and combs are long words with many
+  // candidate factors.
+  vector<Shape<OminoGrid<int>>> bars, ls, stairs, spirals, combs;
+  for (int k = 1; 2 * k + 2 <= options.maxLength; ++k) {
+    bars.push_back(ominoBar(k));
+    spirals.push_back(ominoSpiral(k));
+  }
+  for (int k = 2; 2 * k + 4 <= options.maxLength; ++k) {
+    ls.push_back(ominoL(k));
+  }
+  for (int k = 1; 4 * k + 2 <= options.maxLength; ++k) {
+    stairs.push_back(ominoStair(k));
+  }
+  for (int k = 1; k <= options.maxLength / 4; ++k) {
+    combs.push_back(ominoComb(k));
+  }
+  vector<Shape<OminoGrid<int>>> nonTilers = nonTilingHeptominoes();
+  vector<pair<string, const vector<Shape<OminoGrid<int>>>*>> structured = {
+    {"bar", &bars}, {"L", &ls}, {"stair", &stairs}, {"nontiler", &nonTilers},
+    {"spiral", &spirals}, {"comb", &combs},
+  };
+  for (auto& family: structured) {
+    if (!allSimple(family.first, *family.second)) {
+      return -1;
+    }
+    sets.push_back(traceShapes<OminoGrid<int>>("omino", family.first, *family.second, options, results));
+    if (family.first != "spiral" && family.first != "comb") {
+      sets.back().expected = (family.first != "nontiler");
+    }
+  }
+
+  size_t wrong = 0;
+  for (const WordSet& set: sets) {
+    wrong += verifyKnown(set);
+  }
+  if (wrong > 0) {
+    cerr << wrong << " words with a known result were checked wrongly\n";
+    return -1;
+  }
+
+  for (const WordSet& set: sets) {
+    benchmarkChecker(set, options, results);
+  }
+
+  if (options.json) {
+    printJson(results, options);
+  } else {
+    printTable(results);
+  }
+  return 0;
+}
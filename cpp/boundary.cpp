@@ -17,3 +17,29 @@ boundaryword slice(const boundaryword& boundary, int start, int end) {
   auto last = boundary.begin() + end;
   return boundaryword(first, last);
 }
+
+int least_rotation(const boundaryword& boundary) {
+  int n = boundary.size();
+  // Failure function over the doubled word; k is the best start so far.
+  std::vector<int> f(2 * n, -1);
+  int k = 0;
+  for (int j = 1; j < 2 * n; ++j) {
+    const auto& c = boundary[j % n];
+    int i = f[j - k - 1];
+    while (i != -1 && c != boundary[(k + i + 1) % n]) {
+      if (c < boundary[(k + i + 1) % n]) {
+        k = j - i - 1;
+      }
+      i = f[i];
+    }
+    if (i == -1 && c != boundary[(k + i + 1) % n]) {
+      if (c < boundary[(k + i + 1) % n]) {
+        k = j;
+      }
+      f[j - k] = -1;
+    } else {
+      f[j - k] = i + 1;
+    }
+  }
+  return k % std::max(n, 1);
+}
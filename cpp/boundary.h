@@ -8,9 +8,12 @@
 #include "ominogrid.h"
 #include "shape.h"
 
+#include <bitset>
 #include <map>
 #include <set>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 using boundaryword = std::vector<std::pair<int, int>>;
 
@@ -19,13 +22,34 @@ boundaryword operator+(const boundaryword& lhs,
                        const boundaryword& rhs);
 // Returns slice of 0-indexed boundary [start, end). Returns start to end of the boundary word if end=-1.
 boundaryword slice(const boundaryword& boundary, int start, int end=-1);
+// A mapping of letters, such as a grid's complement or reflection table.
+using LetterMap = std::map<std::pair<int, int>, std::pair<int, int>>;
+
+// Returns the start index of the lexicographically least rotation of the
+// cyclic word (Booth's algorithm, linear time).
+int least_rotation(const boundaryword& boundary);
+
+// Hashes a boundary word letter by letter, for unordered containers keyed
+// by whole words.
+struct BoundaryWordHash {
+  size_t operator()(const boundaryword& boundary) const {
+    size_t h = boundary.size();
+    for (auto& c: boundary) {
+      h = hash_combine(h, point<int>(c.first, c.second).pack());
+    }
+    return h;
+  }
+};
 
 template<typename coord>
 using edge = std::pair<point<coord>, point<coord>>;
 template<typename coord>
 using edgeset = std::set<edge<coord>>;
+// Vertex adjacency of the boundary. The outer container is hashed since
+// it is only ever probed by vertex; the inner sets stay ordered because
+// tracing picks the smallest remaining neighbour at pinch vertices.
 template<typename coord>
-using edgemap = std::map<point<coord>, std::set<point<coord>>>;
+using edgemap = std::unordered_map<point<coord>, std::set<point<coord>>>;
 
 template<typename grid>
 edgeset<typename grid::coord_t> getUniqueTileEdges(const Shape<grid>& shape) {
@@ -53,6 +77,150 @@ edgeset<typename grid::coord_t> getUniqueTileEdges(const Shape<grid>& shape) {
   return ret;
 }
 
+// Returns whether the boundary of shape is a single simple closed curve:
+// the shape is edge connected, has no holes, and no two of its cells meet
+// only at a boundary vertex. Cell vertices are listed with a consistent
+// orientation, so the unique edges are directed and a simple boundary
+// leaves every vertex exactly once and forms one cycle.
+template<typename grid>
+bool hasSimpleBoundary(const Shape<grid>& shape) {
+  using point_t = typename grid::point_t;
+
+  edgeset<typename grid::coord_t> edges = getUniqueTileEdges(shape);
+  if (edges.empty()) {
+    return false;
+  }
+  std::unordered_map<point_t, point_t> next;
+  next.reserve(edges.size());
+  for (auto& e: edges) {
+    if (!next.emplace(e.first, e.second).second) {
+      return false;
+    }
+  }
+  point_t start = edges.begin()->first;
+  point_t cur = start;
+  size_t length = 0;
+  do {
+    cur = next[cur];
+    ++length;
+  } while (cur != start && length <= edges.size());
+  return length == edges.size();
+}
+
+// A boundary word together with the vertex it starts at, so that the
+// position of every letter is known. Words run in the same direction as
+// getBoundaryWord's, but may start at any vertex. simple is false, and
+// word empty, when the shape's boundary isn't a simple closed curve.
+template<typename grid>
+struct TracedBoundary {
+  using point_t = typename grid::point_t;
+
+  bool simple = false;
+  point_t start;
+  boundaryword word;
+};
+
+// Traces the boundary of shape into out, from its unique edges. Returns
+// out.simple.
+template<typename grid>
+bool traceBoundary(const Shape<grid>& shape, TracedBoundary<grid>& out) {
+  using point_t = typename grid::point_t;
+
+  out.word.clear();
+  out.simple = hasSimpleBoundary(shape);
+  if (!out.simple) {
+    return false;
+  }
+  // Unique edges follow the cells' vertex order; the word runs against it.
+  std::unordered_map<point_t, point_t> prev;
+  for (auto& e: getUniqueTileEdges(shape)) {
+    prev.emplace(e.second, e.first);
+  }
+  out.start = prev.begin()->first;
+  point_t cur = out.start;
+  do {
+    point_t next = prev[cur];
+    out.word.push_back({next.getX() - cur.getX(), next.getY() - cur.getY()});
+    cur = next;
+  } while (cur != out.start);
+  return true;
+}
+
+// Given the simple boundary of a shape and a cell outside it, writes the
+// boundary of the shape with the cell added to child, splicing the
+// parent's word instead of retracing the shape. The cell's edges shared
+// with the shape form one run of the parent's word; the child's word is
+// the rest of the parent's word followed by the cell's other edges.
+// Returns child.simple, which is false if the cell isn't edge adjacent to
+// the shape, or if adding it encloses a hole or makes the boundary touch
+// itself at a vertex.
+template<typename grid>
+bool extendBoundary(const TracedBoundary<grid>& parent, const typename grid::point_t& cell,
+                    TracedBoundary<grid>& child) {
+  using point_t = typename grid::point_t;
+
+  child.word.clear();
+  child.simple = false;
+  const std::vector<point_t> verts = grid::getCellVertices(cell);
+  const size_t k = verts.size();
+  const size_t n = parent.word.size();
+
+  // Index of the parent's letter leaving each vertex of the cell, or -1.
+  // A simple boundary passes each vertex once.
+  std::vector<int> at(k, -1);
+  point_t cur = parent.start;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < k; ++j) {
+      if (cur == verts[j]) {
+        at[j] = i;
+      }
+    }
+    cur += point_t(parent.word[i].first, parent.word[i].second);
+  }
+
+  // Edge j of the cell, from verts[j] to verts[j + 1], is shared if the
+  // parent's word runs along it.
+  std::vector<bool> shared(k);
+  size_t numShared = 0;
+  for (size_t j = 0; j < k; ++j) {
+    point_t d = verts[(j + 1) % k] - verts[j];
+    shared[j] = at[j] >= 0 && parent.word[at[j]] == std::make_pair(int(d.getX()), int(d.getY()));
+    numShared += shared[j];
+  }
+  if (numShared == 0 || numShared == k) {
+    return false;
+  }
+  size_t s = 0;
+  while (!shared[s] || shared[(s + k - 1) % k]) {
+    ++s;
+  }
+  for (size_t j = 0; j < numShared; ++j) {
+    if (!shared[(s + j) % k]) {
+      return false;
+    }
+  }
+  // The cell's vertices strictly between the ends of the shared run must
+  // be new to the boundary.
+  const size_t e = (s + numShared) % k;
+  for (size_t j = (e + 1) % k; j != s; j = (j + 1) % k) {
+    if (at[j] >= 0) {
+      return false;
+    }
+  }
+
+  child.start = verts[e];
+  child.word.reserve(n - numShared + k - numShared);
+  for (size_t t = 0; t < n - numShared; ++t) {
+    child.word.push_back(parent.word[(at[s] + numShared + t) % n]);
+  }
+  for (size_t j = s; j != e; j = (j + k - 1) % k) {
+    point_t d = verts[(j + k - 1) % k] - verts[j];
+    child.word.push_back({d.getX(), d.getY()});
+  }
+  child.simple = true;
+  return true;
+}
+
 // Given area based representation of a shape in the hex grid, returns
 // a clockwise boundary word starting at the bottom left point.
 template <typename coord>
@@ -229,7 +397,8 @@ boundaryword getBoundaryWord(const Shape<OminoGrid<coord>>& shape) {
   boundaryword ret;
 
   // bit 0 = N edge, bit 1 = E edge, bit 2 = S edge, bit 3 = W edge.
-  std::map<point_t, std::bitset<4>> vertexToEdges;
+  std::unordered_map<point_t, std::bitset<4>> vertexToEdges;
+  vertexToEdges.reserve(4 * shape.size());
   point_t bottomLeft(100, 100);
 
   for (const point_t& pt: shape) {
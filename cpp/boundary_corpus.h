@@ -0,0 +1,110 @@
+#ifndef BOUNDARY_CORPUS_H
+#define BOUNDARY_CORPUS_H
+
+#include "boundary.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Packs a letter into one byte as two signed 4-bit coordinates, which
+// holds every edge of the supported grids. Returns false if a coordinate
+// is outside [-8, 7].
+inline bool pack_letter(const std::pair<int, int>& letter, uint8_t& byte) {
+  if (letter.first < -8 || letter.first > 7 || letter.second < -8 || letter.second > 7) {
+    return false;
+  }
+  byte = uint8_t(((letter.first & 0xf) << 4) | (letter.second & 0xf));
+  return true;
+}
+
+inline std::pair<int, int> unpack_letter(uint8_t byte) {
+  // Sign-extend each nibble.
+  return {int(int8_t(byte) >> 4), int(int8_t(uint8_t(byte << 4)) >> 4)};
+}
+
+// A read-only view of one packed word in a corpus.
+struct WordSpan {
+  const uint8_t* data;
+  size_t size;
+
+  uint8_t operator[](size_t i) const { return data[i]; }
+  const uint8_t* begin() const { return data; }
+  const uint8_t* end() const { return data + size; }
+};
+
+// Many boundary words stored back to back in one byte buffer, with an
+// offsets array marking where each word starts (the CSR layout). A word
+// costs one byte per letter plus four bytes of offset, instead of a heap
+// allocated vector of 8 byte letters, and walking the corpus reads memory
+// sequentially.
+class BoundaryCorpus {
+ public:
+  size_t size() const { return offsets_.size() - 1; }
+  bool empty() const { return size() == 0; }
+  size_t num_letters() const { return letters_.size(); }
+
+  void reserve(size_t num_words, size_t num_letters) {
+    offsets_.reserve(num_words + 1);
+    letters_.reserve(num_letters);
+  }
+
+  // Removes every word but keeps the storage.
+  void clear() {
+    letters_.clear();
+    offsets_.assign(1, 0);
+  }
+
+  // Appends a word. Returns false and leaves the corpus unchanged if a
+  // letter can't be packed.
+  bool push_back(const boundaryword& word) {
+    size_t old_size = letters_.size();
+    for (auto& c: word) {
+      uint8_t byte;
+      if (!pack_letter(c, byte)) {
+        letters_.resize(old_size);
+        return false;
+      }
+      letters_.push_back(byte);
+    }
+    offsets_.push_back(uint32_t(letters_.size()));
+    return true;
+  }
+
+  // Replaces the contents with num_words words stored in the same layout:
+  // num_words + 1 offsets starting from 0, and the letters they index.
+  void assign(const uint32_t* offsets, size_t num_words, const uint8_t* letters) {
+    offsets_.assign(offsets, offsets + num_words + 1);
+    letters_.assign(letters, letters + offsets[num_words]);
+  }
+
+  // The raw layout, for writing a corpus out as is.
+  const uint32_t* offset_data() const { return offsets_.data(); }
+  const uint8_t* letter_data() const { return letters_.data(); }
+
+  WordSpan operator[](size_t i) const {
+    return {letters_.data() + offsets_[i], size_t(offsets_[i + 1] - offsets_[i])};
+  }
+
+  // Unpacks word i into out, reusing its storage.
+  void decode(size_t i, boundaryword& out) const {
+    WordSpan span = (*this)[i];
+    out.resize(span.size);
+    for (size_t k = 0; k < span.size; ++k) {
+      out[k] = unpack_letter(span[k]);
+    }
+  }
+
+  boundaryword word(size_t i) const {
+    boundaryword out;
+    decode(i, out);
+    return out;
+  }
+
+ private:
+  std::vector<uint8_t> letters_;
+  std::vector<uint32_t> offsets_ = {0};
+};
+
+#endif // BOUNDARY_CORPUS_H
@@ -1,4 +1,5 @@
 #include "boundary.h"
+#include "boundary_corpus.h"
 #include "hexgrid.h"
 #include "iamondgrid.h"
 #include "ominogrid.h"
@@ -7,9 +8,24 @@
 #include <iostream>
 #include <map>
 #include <string>
+#include <unordered_set>
 
 using namespace std;
 
+// Whether b is a rotation of a.
+bool isRotation(const boundaryword& a, const boundaryword& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  boundaryword doubled = a + a;
+  for (size_t r = 0; r < a.size(); ++r) {
+    if (equal(b.begin(), b.end(), doubled.begin() + r)) {
+      return true;
+    }
+  }
+  return a.empty();
+}
+
 int main() {
   map<pair<int, int>, char> ominoMap{
     {{1, 0}, 'E'},
@@ -82,4 +98,71 @@ int main() {
     cout << "Iamond boundary test failed.\n";
     cout << "Got: " << got << " Want: " << want << "\n";
   }
+
+  // Packed keys must round trip and distinguish every cell of a small
+  // window, including negative coordinates.
+  unordered_set<point<int>> seen;
+  unordered_set<uint64_t> keys;
+  bool packOk = true;
+  for (int x = -20; x <= 20; ++x) {
+    for (int y = -20; y <= 20; ++y) {
+      point<int> p(x, y);
+      seen.insert(p);
+      keys.insert(p.pack());
+      packOk = packOk && (point<int>::unpack(p.pack()) == p);
+    }
+  }
+  if (packOk && seen.size() == 41 * 41 && keys.size() == 41 * 41) {
+    cout << "Point hash test case passed.\n";
+  } else {
+    cout << "Point hash test failed.\n";
+  }
+
+  // Words stored in a corpus must come back unchanged.
+  BoundaryCorpus corpus;
+  corpus.push_back(ominoBoundary);
+  corpus.push_back(boundaryword());
+  corpus.push_back(hexBoundary);
+  corpus.push_back(iamondBoundary);
+  bool rejected = !corpus.push_back({{1, 0}, {9, 0}});
+  if (rejected && corpus.size() == 4 && corpus.word(0) == ominoBoundary && corpus[1].size == 0 &&
+      corpus.word(2) == hexBoundary && corpus.word(3) == iamondBoundary &&
+      corpus.num_letters() == ominoBoundary.size() + hexBoundary.size() + iamondBoundary.size()) {
+    cout << "Corpus test case passed.\n";
+  } else {
+    cout << "Corpus test failed.\n";
+  }
+
+  // Growing a ring of cells one at a time, spliced boundaries must match
+  // traced ones until the last cell closes the ring around a hole.
+  vector<point<int>> ring = {{1, 0}, {2, 0}, {2, 1}, {2, 2}, {1, 2}, {0, 2}, {0, 1}};
+  Shape<OminoGrid<int>> grown;
+  grown.add(0, 0);
+  TracedBoundary<OminoGrid<int>> traced, spliced;
+  bool spliceOk = traceBoundary(grown, traced) && isRotation(getBoundaryWord(grown), traced.word);
+  for (size_t i = 0; i < ring.size(); ++i) {
+    grown.add(ring[i]);
+    bool simple = extendBoundary(traced, ring[i], spliced);
+    if (i + 1 < ring.size()) {
+      spliceOk = spliceOk && simple && isRotation(getBoundaryWord(grown), spliced.word);
+    } else {
+      spliceOk = spliceOk && !simple && !hasSimpleBoundary(grown);
+    }
+    traced = spliced;
+  }
+  Shape<HexGrid<int>> hexGrown;
+  hexGrown.add(0, 0);
+  TracedBoundary<HexGrid<int>> hexTraced, hexSpliced;
+  traceBoundary(hexGrown, hexTraced);
+  hexGrown.add(0, 1);
+  spliceOk = spliceOk && extendBoundary(hexTraced, point<int>(0, 1), hexSpliced);
+  hexGrown.add(1, 0);
+  spliceOk = spliceOk && extendBoundary(hexSpliced, point<int>(1, 0), hexTraced) &&
+             isRotation(hexBoundary, hexTraced.word) &&
+             !extendBoundary(hexTraced, point<int>(5, 5), hexSpliced);
+  if (spliceOk) {
+    cout << "Incremental boundary test case passed.\n";
+  } else {
+    cout << "Incremental boundary test failed.\n";
+  }
 }
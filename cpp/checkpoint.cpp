@@ -0,0 +1,203 @@
+#include "checkpoint.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <sys/stat.h>
+
+namespace {
+
+const char MAGIC[] = "isohedral-checkpoint";
+const int FORMAT_VERSION = 1;
+
+// Writes the indices of the done tasks as ranges, e.g. "0-15 17 19-30".
+void write_ranges(std::ostream& out, const std::vector<bool>& done) {
+  const char* separator = "";
+  for (size_t i = 0; i < done.size();) {
+    if (!done[i]) {
+      ++i;
+      continue;
+    }
+    size_t j = i;
+    while (j + 1 < done.size() && done[j + 1]) {
+      ++j;
+    }
+    out << separator << i;
+    if (j > i) {
+      out << "-" << j;
+    }
+    separator = " ";
+    i = j + 1;
+  }
+}
+
+bool parse_ranges(const std::string& value, std::vector<bool>& done) {
+  std::istringstream ranges(value);
+  std::string range;
+  while (ranges >> range) {
+    size_t dash = range.find('-');
+    if (dash != std::string::npos) {
+      range[dash] = ' ';
+    }
+    std::istringstream bounds(range);
+    size_t first, last;
+    if (!(bounds >> first)) {
+      return false;
+    }
+    last = first;
+    if (dash != std::string::npos && !(bounds >> last)) {
+      return false;
+    }
+    if (first > last || last >= done.size()) {
+      return false;
+    }
+    for (size_t i = first; i <= last; ++i) {
+      done[i] = true;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+InputStamp stamp_input(const std::string& path) {
+  InputStamp stamp;
+  struct stat info;
+  if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+    stamp.size = uint64_t(info.st_size);
+    stamp.mtime_ns = int64_t(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+  }
+  return stamp;
+}
+
+bool write_checkpoint(const std::string& path, const CheckpointState& state) {
+  std::string temp = path + ".tmp";
+  {
+    std::ofstream out(temp);
+    if (!out) {
+      return false;
+    }
+    out << MAGIC << " " << FORMAT_VERSION << "\n";
+    write_partial_fields(out, state.totals);
+    out << "input " << state.input.size << " " << state.input.mtime_ns << "\n"
+        << "tasks " << state.num_tasks << " " << state.target << "\n"
+        << "lines " << state.lines_done << "\n"
+        << "done ";
+    write_ranges(out, state.done);
+    out << "\n";
+    out.close();
+    if (!out) {
+      return false;
+    }
+  }
+  return std::rename(temp.c_str(), path.c_str()) == 0;
+}
+
+bool read_checkpoint(const std::string& path, CheckpointState& state, std::string& error) {
+  error.clear();
+  std::ifstream in(path);
+  if (!in) {
+    return false;
+  }
+  state = CheckpointState();
+  std::string line;
+  std::string magic;
+  int version = 0;
+  std::getline(in, line);
+  std::istringstream header(line);
+  if (!(header >> magic >> version) || magic != MAGIC || version != FORMAT_VERSION) {
+    error = "Not a checkpoint file: " + path;
+    return false;
+  }
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::string key = line.substr(0, line.find(' '));
+    std::string value = line.size() > key.size() ? line.substr(key.size() + 1) : "";
+    std::istringstream fields(value);
+    bool ok;
+    if (key == "input") {
+      ok = bool(fields >> state.input.size >> state.input.mtime_ns);
+    } else if (key == "tasks") {
+      ok = bool(fields >> state.num_tasks >> state.target);
+      state.done.assign(state.num_tasks, false);
+    } else if (key == "lines") {
+      ok = bool(fields >> state.lines_done);
+    } else if (key == "done") {
+      ok = parse_ranges(value, state.done);
+    } else {
+      ok = parse_partial_field(key, value, state.totals);
+    }
+    if (!ok) {
+      error = "Malformed line in " + path + ": " + line;
+      return false;
+    }
+  }
+  return true;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string& path, double interval_seconds,
+                                   const CheckpointState& state)
+    : path_(path), interval_seconds_(interval_seconds), state_(state) {
+  state_.done.resize(state_.num_tasks);
+  thread_ = std::thread([this]() { run(); });
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  stop();
+}
+
+void CheckpointWriter::complete_task(size_t task, const Tally& counts,
+                                     const std::vector<SizeTally>& sizes) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  state_.done[task] = true;
+  state_.totals.counts += counts;
+  if (state_.totals.sizes.size() < sizes.size()) {
+    state_.totals.sizes.resize(sizes.size());
+  }
+  for (size_t size = 1; size < sizes.size(); ++size) {
+    state_.totals.sizes[size] += sizes[size];
+  }
+}
+
+void CheckpointWriter::complete_chunk(size_t chunk, size_t end_line, const Tally& counts) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  pending_chunks_[chunk] = {end_line, counts};
+  for (auto it = pending_chunks_.begin();
+       it != pending_chunks_.end() && it->first == next_chunk_;
+       it = pending_chunks_.erase(it), ++next_chunk_) {
+    state_.lines_done = it->second.end_line;
+    state_.totals.counts += it->second.counts;
+  }
+}
+
+bool CheckpointWriter::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  return !failed_;
+}
+
+void CheckpointWriter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto interval = std::chrono::duration<double>(interval_seconds_);
+  while (true) {
+    bool last = wake_.wait_for(lock, interval, [this]() { return stopping_; });
+    CheckpointState snapshot = state_;
+    lock.unlock();
+    bool written = write_checkpoint(path_, snapshot);
+    lock.lock();
+    failed_ = failed_ || !written;
+    if (last) {
+      return;
+    }
+  }
+}
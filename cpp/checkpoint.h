@@ -0,0 +1,113 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "partial_result.h"
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Identifies the input file of a run by its size and modification time,
+// so that a checkpoint isn't resumed on a file that was replaced or
+// changed since. Both are 0 for enumerations and for inputs that aren't
+// regular files, such as pipes, which can't be identified this way.
+struct InputStamp {
+  uint64_t size = 0;
+  int64_t mtime_ns = 0;
+
+  bool operator==(const InputStamp& other) const {
+    return size == other.size && mtime_ns == other.mtime_ns;
+  }
+  bool operator!=(const InputStamp& other) const { return !(*this == other); }
+};
+
+// Returns the stamp of the file at path, or an empty stamp if it isn't a
+// regular file.
+InputStamp stamp_input(const std::string& path);
+
+// The progress of a run, saved so that a preempted run can resume where
+// it left off.
+//
+// Work is divided into numbered tasks (batches of a mapped file, or
+// subtrees of an enumeration) that finish in any order, and totals counts
+// exactly the finished ones. A streamed input is read in order instead,
+// and lines_done is the number of input lines whose results are all in
+// totals. target records the parameter the work was divided with, so a
+// resumed run divides it the same way whatever its thread count.
+//
+// The file holds the fields of a partial result after its own header,
+// followed by:
+//
+//   input 183040512 1760863724123456789
+//   tasks 97 97
+//   lines 0
+//   done 0-15 17 19-30
+struct CheckpointState {
+  PartialResult totals;
+  InputStamp input;
+  size_t num_tasks = 0;
+  size_t target = 0;
+  std::vector<bool> done;
+  size_t lines_done = 0;
+};
+
+// Writes state to a temporary file and renames it over path, so a
+// checkpoint is never seen half written.
+bool write_checkpoint(const std::string& path, const CheckpointState& state);
+
+// Returns false and sets error if the file can't be read or is malformed.
+// A missing file is reported with an empty error.
+bool read_checkpoint(const std::string& path, CheckpointState& state, std::string& error);
+
+// Collects finished work from the checker threads and writes checkpoints
+// from its own thread at a fixed interval. Workers only take a lock to add
+// their counts, and the file is written from a copy of the state outside
+// the lock, so a slow disk never stalls them.
+class CheckpointWriter {
+ public:
+  CheckpointWriter(const std::string& path, double interval_seconds, const CheckpointState& state);
+  CheckpointWriter(const CheckpointWriter&) = delete;
+  CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+  ~CheckpointWriter();
+
+  // Records that a task finished with the given counts. sizes may be
+  // empty.
+  void complete_task(size_t task, const Tally& counts, const std::vector<SizeTally>& sizes);
+
+  // Records that chunk number chunk of a streamed input finished, where
+  // the chunk ends before input line end_line. Chunks are numbered in
+  // input order from 0 and are added to the totals once all earlier
+  // chunks have finished.
+  void complete_chunk(size_t chunk, size_t end_line, const Tally& counts);
+
+  // Stops the writing thread and writes a last checkpoint. Returns false
+  // if any write failed.
+  bool stop();
+
+ private:
+  struct Chunk {
+    size_t end_line;
+    Tally counts;
+  };
+
+  void run();
+
+  const std::string path_;
+  const double interval_seconds_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+  bool failed_ = false;
+  CheckpointState state_;
+  // Finished chunks that wait for an earlier one.
+  size_t next_chunk_ = 0;
+  std::map<size_t, Chunk> pending_chunks_;
+  std::thread thread_;
+};
+
+#endif // CHECKPOINT_H
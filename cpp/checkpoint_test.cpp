@@ -0,0 +1,157 @@
+#include "checkpoint.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+// Returns the path of a new, empty temporary file.
+string tempPath() {
+  char path[] = "/tmp/checkpoint_testXXXXXX";
+  int fd = mkstemp(path);
+  if (fd == -1) {
+    return "";
+  }
+  close(fd);
+  return path;
+}
+
+// Writes text to a new temporary file and returns its path.
+string writeTemp(const string& text) {
+  char path[] = "/tmp/checkpoint_testXXXXXX";
+  int fd = mkstemp(path);
+  if (fd == -1 || write(fd, text.data(), text.size()) != ssize_t(text.size())) {
+    return "";
+  }
+  close(fd);
+  return path;
+}
+
+// Reads the checkpoint file with the given contents.
+bool readText(const string& text, CheckpointState& state, string& error) {
+  string path = writeTemp(text);
+  bool ok = !path.empty() && read_checkpoint(path, state, error);
+  unlink(path.c_str());
+  return ok;
+}
+
+CheckpointState makeState() {
+  CheckpointState state;
+  state.totals.grid = "hex";
+  state.totals.source = "hex9.txt";
+  state.totals.split = "bytes";
+  state.totals.counts = {4000, 1200, 30, 2};
+  state.input = {183040512, 1760863724123456789};
+  state.num_tasks = 12;
+  state.target = 4096;
+  // Single tasks, runs, and a run at each end.
+  state.done = {true, true, false, true, false, false, true, true, true, false, true, true};
+  state.lines_done = 0;
+  return state;
+}
+
+bool sameState(const CheckpointState& lhs, const CheckpointState& rhs) {
+  const Tally& a = lhs.totals.counts;
+  const Tally& b = rhs.totals.counts;
+  return lhs.totals.grid == rhs.totals.grid && lhs.totals.source == rhs.totals.source &&
+         lhs.totals.split == rhs.totals.split && a.num_polyforms == b.num_polyforms &&
+         a.num_isohedral == b.num_isohedral && a.num_not_simple == b.num_not_simple &&
+         a.num_unchecked == b.num_unchecked && lhs.input == rhs.input && lhs.num_tasks == rhs.num_tasks &&
+         lhs.target == rhs.target && lhs.done == rhs.done && lhs.lines_done == rhs.lines_done;
+}
+
+int main() {
+  // A written checkpoint reads back unchanged, with no tasks done, some
+  // done or all done.
+  bool fileOk = true;
+  {
+    string path = tempPath();
+    vector<CheckpointState> states(3, makeState());
+    states[1].done.assign(states[1].num_tasks, false);
+    states[2].done.assign(states[2].num_tasks, true);
+    for (const CheckpointState& written: states) {
+      CheckpointState read;
+      string error;
+      fileOk = write_checkpoint(path, written) && read_checkpoint(path, read, error) &&
+               sameState(read, written) && fileOk;
+    }
+    unlink(path.c_str());
+
+    // A missing file is not an error.
+    CheckpointState read;
+    string error = "unset";
+    fileOk = !read_checkpoint(path, read, error) && error.empty() && fileOk;
+  }
+  if (fileOk) {
+    cout << "Checkpoint file test case passed.\n";
+  } else {
+    cout << "Checkpoint file test failed.\n";
+  }
+
+  // Malformed checkpoints are refused with an error.
+  bool malformedOk = true;
+  {
+    const string fields = "isohedral-checkpoint 1\ngrid omino\nsource a.txt\nsplit bytes\nshard 0 1\n"
+                          "polyforms 10\nisohedral 4\ninput 100 200\nlines 0\n";
+    CheckpointState state;
+    string error;
+    malformedOk = readText(fields + "tasks 8 64\ndone 0-3 5 7\n", state, error) &&
+                  state.done == vector<bool>{true, true, true, true, false, true, false, true};
+    const char* malformed[] = {
+      "tasks 8 64\ndone 5-3\n",
+      "tasks 8 64\ndone 8\n",
+      "tasks 8 64\ndone 6-8\n",
+      "tasks 8 64\ndone x\n",
+      "tasks 8 64\ndone 2-\n",
+      "tasks 8 64\ndone -2\n",
+      "done 0\ntasks 8 64\n",
+      "tasks 8\n",
+      "tasks 8 64\nlines many\n",
+      "tasks 8 64\ninput 100\n",
+    };
+    for (const char* text: malformed) {
+      malformedOk = !readText(fields + text, state, error) && !error.empty() && malformedOk;
+    }
+    malformedOk = !readText("isohedral-partial 1\n", state, error) && !error.empty() && malformedOk;
+    malformedOk = !readText("isohedral-checkpoint 2\n", state, error) && !error.empty() && malformedOk;
+    malformedOk = !readText("", state, error) && !error.empty() && malformedOk;
+  }
+  if (malformedOk) {
+    cout << "Malformed checkpoint test case passed.\n";
+  } else {
+    cout << "Malformed checkpoint test failed.\n";
+  }
+
+  // Chunks of a streamed input are added in order, whatever order they
+  // finish in, and tasks are recorded as done.
+  bool writerOk = true;
+  {
+    string path = tempPath();
+    CheckpointState initial;
+    initial.num_tasks = 4;
+    {
+      CheckpointWriter writer(path, 3600, initial);
+      writer.complete_chunk(1, 200, {100, 10, 1, 0});
+      writer.complete_chunk(3, 400, {100, 10, 1, 0});
+      writer.complete_chunk(0, 100, {100, 10, 1, 1});
+      writer.complete_task(2, {5, 1, 0, 0}, {});
+      writerOk = writer.stop();
+    }
+    CheckpointState read;
+    string error;
+    writerOk = read_checkpoint(path, read, error) && read.lines_done == 200 &&
+               read.totals.counts.num_polyforms == 205 && read.totals.counts.num_isohedral == 21 &&
+               read.totals.counts.num_not_simple == 2 && read.totals.counts.num_unchecked == 1 &&
+               read.done == vector<bool>{false, false, true, false} && writerOk;
+    unlink(path.c_str());
+  }
+  if (writerOk) {
+    cout << "Checkpoint writer test case passed.\n";
+  } else {
+    cout << "Checkpoint writer test failed.\n";
+  }
+}
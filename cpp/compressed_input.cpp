@@ -0,0 +1,253 @@
+#include "compressed_input.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace {
+
+const unsigned char GZIP_MAGIC[2] = {0x1f, 0x8b};
+const unsigned char ZSTD_MAGIC[4] = {0x28, 0xb5, 0x2f, 0xfd};
+
+}  // namespace
+
+Compression detect_compression(const char* data, size_t size) {
+  if (size >= sizeof(GZIP_MAGIC) && memcmp(data, GZIP_MAGIC, sizeof(GZIP_MAGIC)) == 0) {
+    return COMPRESSION_GZIP;
+  }
+  if (size >= sizeof(ZSTD_MAGIC) && memcmp(data, ZSTD_MAGIC, sizeof(ZSTD_MAGIC)) == 0) {
+    return COMPRESSION_ZSTD;
+  }
+  return COMPRESSION_NONE;
+}
+
+DecompressingReader::~DecompressingReader() {
+  std::string error;
+  close(error);
+}
+
+bool DecompressingReader::open(const std::string& path, std::string& error) {
+  fd_ = ::open(path.c_str(), O_RDONLY);
+  if (fd_ == -1) {
+    error = "Error opening file: " + path;
+    return false;
+  }
+  // Read enough to recognize the format. A pipe may deliver fewer bytes
+  // at a time, so keep reading until the magic fits or the input ends.
+  head_.resize(BLOCK_SIZE);
+  size_t size = 0;
+  while (size < sizeof(ZSTD_MAGIC)) {
+    ssize_t n = ::read(fd_, head_.data() + size, head_.size() - size);
+    if (n <= 0) {
+      break;
+    }
+    size += n;
+  }
+  head_.resize(size);
+  compression_ = detect_compression(head_.data(), head_.size());
+#ifndef HAVE_ZSTD
+  if (compression_ == COMPRESSION_ZSTD) {
+    error = "zstd input needs a build with ZSTD=1: " + path;
+    ::close(fd_);
+    fd_ = -1;
+    return false;
+  }
+#endif
+  thread_ = std::thread([this]() { run(); });
+  return true;
+}
+
+bool DecompressingReader::close(std::string& error) {
+  if (fd_ == -1) {
+    return true;
+  }
+  // Drain the ring so a reading thread waiting for room can finish.
+  std::vector<char> block;
+  while (ring_.pop(block)) {
+  }
+  thread_.join();
+  ::close(fd_);
+  fd_ = -1;
+  error = error_;
+  return error_.empty();
+}
+
+DecompressingReader::Buffer::int_type DecompressingReader::Buffer::underflow() {
+  while (gptr() == egptr()) {
+    if (!reader_.ring_.pop(block_)) {
+      return traits_type::eof();
+    }
+    setg(block_.data(), block_.data(), block_.data() + block_.size());
+  }
+  return traits_type::to_int_type(*gptr());
+}
+
+size_t DecompressingReader::Buffer::peek(char* data, size_t size) {
+  // Blocks may be shorter than size, so the unread bytes are gathered
+  // into one block first.
+  if (size_t(egptr() - gptr()) < size) {
+    std::vector<char> unread(gptr(), egptr());
+    std::vector<char> next;
+    while (unread.size() < size && reader_.ring_.pop(next)) {
+      unread.insert(unread.end(), next.begin(), next.end());
+    }
+    block_ = std::move(unread);
+    setg(block_.data(), block_.data(), block_.data() + block_.size());
+  }
+  size_t n = std::min(size, size_t(egptr() - gptr()));
+  memcpy(data, gptr(), n);
+  return n;
+}
+
+void DecompressingReader::run() {
+  bool ok;
+  switch (compression_) {
+    case COMPRESSION_GZIP:
+      ok = read_gzip();
+      break;
+    case COMPRESSION_ZSTD:
+      ok = read_zstd();
+      break;
+    default:
+      ok = read_plain();
+  }
+  if (!ok && error_.empty()) {
+    error_ = "Error reading input";
+  }
+  ring_.close();
+}
+
+long DecompressingReader::read_raw(char* data, size_t size) {
+  if (head_pos_ < head_.size()) {
+    size_t n = std::min(size, head_.size() - head_pos_);
+    memcpy(data, head_.data() + head_pos_, n);
+    head_pos_ += n;
+    return long(n);
+  }
+  return long(::read(fd_, data, size));
+}
+
+void DecompressingReader::emit(std::vector<char>& block) {
+  if (!block.empty()) {
+    ring_.push(std::move(block));
+  }
+  block = std::vector<char>();
+}
+
+bool DecompressingReader::read_plain() {
+  std::vector<char> block;
+  while (true) {
+    block.resize(BLOCK_SIZE);
+    long n = read_raw(block.data(), block.size());
+    if (n < 0) {
+      return false;
+    }
+    if (n == 0) {
+      return true;
+    }
+    block.resize(n);
+    emit(block);
+  }
+}
+
+bool DecompressingReader::read_gzip() {
+  z_stream z = {};
+  // 32 added to the window bits detects a gzip or zlib header.
+  if (inflateInit2(&z, 15 + 32) != Z_OK) {
+    return false;
+  }
+  std::vector<char> in(BLOCK_SIZE);
+  std::vector<char> block;
+  bool ok = true;
+  bool at_member_end = false;
+  // inflate may hold decoded data back when it fills a block, so more
+  // input is only read after a call that left room in its block.
+  bool output_full = false;
+  while (ok) {
+    if (z.avail_in == 0 && !output_full) {
+      long n = read_raw(in.data(), in.size());
+      if (n <= 0) {
+        ok = n == 0 && at_member_end;
+        if (!ok && n == 0) {
+          error_ = "Compressed input is truncated";
+        }
+        break;
+      }
+      z.next_in = reinterpret_cast<Bytef*>(in.data());
+      z.avail_in = uInt(n);
+    }
+    block.resize(BLOCK_SIZE);
+    z.next_out = reinterpret_cast<Bytef*>(block.data());
+    z.avail_out = uInt(block.size());
+    int status = inflate(&z, Z_NO_FLUSH);
+    output_full = status == Z_OK && z.avail_out == 0;
+    block.resize(block.size() - z.avail_out);
+    emit(block);
+    if (status == Z_STREAM_END) {
+      // gzip allows several members back to back, as written by
+      // concatenating compressed files.
+      at_member_end = true;
+      inflateReset(&z);
+    } else if (status == Z_OK) {
+      at_member_end = false;
+    } else if (status != Z_BUF_ERROR) {
+      // Z_BUF_ERROR only means that a call for pending output found none.
+      error_ = "Corrupt gzip input";
+      ok = false;
+    }
+  }
+  inflateEnd(&z);
+  return ok;
+}
+
+bool DecompressingReader::read_zstd() {
+#ifdef HAVE_ZSTD
+  ZSTD_DStream* stream = ZSTD_createDStream();
+  if (!stream) {
+    return false;
+  }
+  std::vector<char> in(ZSTD_DStreamInSize());
+  std::vector<char> block;
+  ZSTD_inBuffer input = {in.data(), 0, 0};
+  size_t last = 0;
+  bool ok = true;
+  // zstd may hold decoded data back when it fills a block before the
+  // frame ends, so more input is only read after a call that left room in
+  // its block or finished the frame.
+  bool output_full = false;
+  while (ok) {
+    if (input.pos == input.size && !output_full) {
+      long n = read_raw(in.data(), in.size());
+      if (n <= 0) {
+        // last is 0 once a frame has been fully decoded.
+        ok = n == 0 && last == 0;
+        if (!ok && n == 0) {
+          error_ = "Compressed input is truncated";
+        }
+        break;
+      }
+      input = {in.data(), size_t(n), 0};
+    }
+    block.resize(BLOCK_SIZE);
+    ZSTD_outBuffer output = {block.data(), block.size(), 0};
+    last = ZSTD_decompressStream(stream, &output, &input);
+    output_full = output.pos == output.size && last != 0;
+    if (ZSTD_isError(last)) {
+      error_ = std::string("Corrupt zstd input: ") + ZSTD_getErrorName(last);
+      ok = false;
+    }
+    block.resize(output.pos);
+    emit(block);
+  }
+  ZSTD_freeDStream(stream);
+  return ok;
+#else
+  return false;
+#endif
+}
@@ -0,0 +1,92 @@
+#ifndef COMPRESSED_INPUT_H
+#define COMPRESSED_INPUT_H
+
+#include "work_queue.h"
+
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum Compression {
+  COMPRESSION_NONE,
+  COMPRESSION_GZIP,
+  COMPRESSION_ZSTD
+};
+
+// Recognizes a compressed input by its first bytes.
+Compression detect_compression(const char* data, size_t size);
+
+// Reads a file or pipe on a dedicated thread and passes its bytes on
+// through a bounded ring of buffers, decompressing them first if the
+// input is gzip compressed (or zstd compressed, in builds with ZSTD=1).
+// stream() reads the bytes like any other istream, so parsing overlaps
+// with reading and decompression, and a compressed input never needs a
+// decompressed copy on disk.
+class DecompressingReader {
+ public:
+  // Size of the blocks passed through the ring.
+  static constexpr size_t BLOCK_SIZE = 256 << 10;
+
+  DecompressingReader() : buffer_(*this), stream_(&buffer_) {}
+  DecompressingReader(const DecompressingReader&) = delete;
+  DecompressingReader& operator=(const DecompressingReader&) = delete;
+  ~DecompressingReader();
+
+  // Opens path and starts reading. Returns false and sets error if it
+  // can't be opened or uses a compression this build doesn't support.
+  bool open(const std::string& path, std::string& error);
+  bool is_open() const { return fd_ != -1; }
+
+  std::istream& stream() { return stream_; }
+
+  // Copies up to size bytes from the start of what stream() reads next
+  // into data without consuming them, e.g. to recognize a file format.
+  // Returns the number copied, which is less than size only at the end of
+  // the input.
+  size_t peek(char* data, size_t size) { return buffer_.peek(data, size); }
+  Compression compression() const { return compression_; }
+
+  // Waits for the reading thread and closes the input. Returns false and
+  // sets error if the input couldn't be read or decompressed, in which
+  // case the stream ended early.
+  bool close(std::string& error);
+
+ private:
+  // Hands out the blocks of the ring one at a time.
+  class Buffer : public std::streambuf {
+   public:
+    explicit Buffer(DecompressingReader& reader) : reader_(reader) {}
+
+    size_t peek(char* data, size_t size);
+
+   protected:
+    int_type underflow() override;
+
+   private:
+    DecompressingReader& reader_;
+    std::vector<char> block_;
+  };
+
+  void run();
+  bool read_plain();
+  bool read_gzip();
+  bool read_zstd();
+  // Reads up to size bytes, starting with the bytes already read for
+  // detection. Returns -1 on error and 0 at the end of the input.
+  long read_raw(char* data, size_t size);
+  void emit(std::vector<char>& block);
+
+  int fd_ = -1;
+  Compression compression_ = COMPRESSION_NONE;
+  std::vector<char> head_;
+  size_t head_pos_ = 0;
+  std::string error_;
+  BoundedQueue<std::vector<char>> ring_{8};
+  std::thread thread_;
+  Buffer buffer_;
+  std::istream stream_;
+};
+
+#endif // COMPRESSED_INPUT_H
@@ -0,0 +1,113 @@
+#include "compressed_input.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+
+#include <unistd.h>
+#include <zlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+using namespace std;
+
+// Lines of gen style text adding up to exactly size bytes.
+string genText(size_t size, mt19937& rng) {
+  string text;
+  while (text.size() < size) {
+    text += "O?";
+    for (int i = 0; i < 16; ++i) {
+      text += " " + to_string(rng() % 8);
+    }
+    text += "\n";
+  }
+  text.resize(size);
+  return text;
+}
+
+// Writes data to a new temporary file and returns its path.
+string writeTemp(const string& data) {
+  char path[] = "/tmp/compressed_input_testXXXXXX";
+  int fd = mkstemp(path);
+  if (fd == -1 || write(fd, data.data(), data.size()) != ssize_t(data.size())) {
+    return "";
+  }
+  close(fd);
+  return path;
+}
+
+// Compresses text into a gzip member.
+string gzipped(const string& text) {
+  char path[] = "/tmp/compressed_input_testXXXXXX";
+  gzFile out = gzdopen(mkstemp(path), "wb");
+  gzwrite(out, text.data(), unsigned(text.size()));
+  gzclose(out);
+  ifstream in(path, ios::binary);
+  string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  unlink(path);
+  return data;
+}
+
+// Reads a compressed input back through a reader and compares it with
+// the text it was made from.
+bool readsBack(const string& compressed, const string& text, Compression compression) {
+  string path = writeTemp(compressed);
+  DecompressingReader reader;
+  string error;
+  if (path.empty() || !reader.open(path, error)) {
+    return false;
+  }
+  string got((istreambuf_iterator<char>(reader.stream())), istreambuf_iterator<char>());
+  bool ok = reader.close(error) && reader.compression() == compression && got == text;
+  unlink(path.c_str());
+  if (!ok) {
+    cout << "Read " << got.size() << " of " << text.size() << " bytes. " << error << "\n";
+  }
+  return ok;
+}
+
+int main() {
+  mt19937 rng(7);
+  // Decoded sizes that end exactly on a block boundary, where a
+  // decompressor may still hold data back after filling a block, and
+  // one that doesn't.
+  const size_t B = DecompressingReader::BLOCK_SIZE;
+  const size_t sizes[] = {B, 2 * B, 4 * B, 2 * B + 1};
+
+  bool gzipOk = true;
+  for (size_t size: sizes) {
+    string text = genText(size, rng);
+    gzipOk = readsBack(gzipped(text), text, COMPRESSION_GZIP) && gzipOk;
+  }
+  if (gzipOk) {
+    cout << "Gzip input test case passed.\n";
+  } else {
+    cout << "Gzip input test failed.\n";
+  }
+
+#ifdef HAVE_ZSTD
+  auto zstdFrame = [](const string& text) {
+    string compressed(ZSTD_compressBound(text.size()), '\0');
+    compressed.resize(ZSTD_compress(&compressed[0], compressed.size(), text.data(), text.size(), 3));
+    return compressed;
+  };
+  bool zstdOk = true;
+  for (size_t size: sizes) {
+    string text = genText(size, rng);
+    zstdOk = readsBack(zstdFrame(text), text, COMPRESSION_ZSTD) && zstdOk;
+  }
+  // Frames back to back, the first ending on a block boundary.
+  string first = genText(B, rng);
+  string second = genText(B + 100, rng);
+  zstdOk = readsBack(zstdFrame(first) + zstdFrame(second), first + second, COMPRESSION_ZSTD) && zstdOk;
+  if (zstdOk) {
+    cout << "Zstd input test case passed.\n";
+  } else {
+    cout << "Zstd input test failed.\n";
+  }
+#endif
+}
@@ -0,0 +1,219 @@
+#ifndef ENUMERATE_H
+#define ENUMERATE_H
+
+#include "boundary.h"
+#include "geom.h"
+#include "shape.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+// A node of the search tree for fixed polyforms: the cells placed so far,
+// their boundary, the untried cells that may still be added below this
+// node, and every cell considered on the way from the root (placed,
+// untried, or skipped by an earlier sibling).
+template<typename grid>
+struct EnumerationNode {
+  using point_t = typename grid::point_t;
+
+  std::vector<point_t> cells;
+  TracedBoundary<grid> boundary;
+  std::vector<point_t> untried;
+  std::vector<point_t> seen;
+};
+
+// Enumerates polyforms of a grid by Redelmeier's method. Every fixed
+// polyform is translated so that its least cell (in point order) lies on
+// the origin of its tile type, so the search runs once from each origin
+// and only ever adds cells greater than it. Each polyform is produced
+// exactly once, by adding one cell to its parent, so no set of shapes
+// found so far has to be kept.
+//
+// The search is split into independent subtrees for parallel use: split()
+// walks the top levels of the tree, and search() runs below one node with
+// its own state.
+//
+// Visitors are called as visit(cells, parent), where parent is the
+// boundary of the polyform without its last cell (empty for a single
+// cell). The search keeps the boundaries of the polyforms it extends,
+// each spliced from its parent's with extendBoundary, and a visitor that
+// needs the polyform's own boundary gets it the same way from
+// childBoundary.
+template<typename grid>
+class PolyformEnumerator {
+ public:
+  using point_t = typename grid::point_t;
+  using Node = EnumerationNode<grid>;
+
+  explicit PolyformEnumerator(int maxSize)
+      : maxSize_(maxSize), radius_(2 * maxSize + 4), width_(2 * radius_ + 1) {}
+
+  int maxSize() const { return maxSize_; }
+
+  // Expands the tree breadth first until there are at least minNodes
+  // nodes in a level or the polyforms reach the maximum size, and returns
+  // that level. Calls visit(cells) for every polyform above and in the
+  // returned level.
+  template<typename Visit>
+  std::vector<Node> split(size_t minNodes, Visit&& visit) const {
+    std::vector<Node> level;
+    Shape<grid> scratch;
+    const TracedBoundary<grid> none;
+    for (size_t t = 0; t < grid::num_tile_types; ++t) {
+      point_t root = grid::origins[t];
+      Node node;
+      node.cells.push_back(root);
+      node.seen.push_back(root);
+      addNeighbours(node, root, root);
+      visit(node.cells, none);
+      childBoundary(none, node.cells, node.boundary, scratch);
+      level.push_back(std::move(node));
+    }
+    while (level.size() < minNodes && (int)level.front().cells.size() < maxSize_) {
+      std::vector<Node> next;
+      for (const Node& node: level) {
+        for (size_t i = node.untried.size(); i-- > 0;) {
+          point_t c = node.untried[i];
+          Node child = node;
+          child.cells.push_back(c);
+          child.untried.resize(i);
+          addNeighbours(child, c, node.cells.front());
+          visit(child.cells, node.boundary);
+          childBoundary(node.boundary, child.cells, child.boundary, scratch);
+          next.push_back(std::move(child));
+        }
+      }
+      level = std::move(next);
+    }
+    return level;
+  }
+
+  // Calls visit(cells) for every polyform strictly below node.
+  template<typename Visit>
+  void search(const Node& node, Visit&& visit) const {
+    if ((int)node.cells.size() >= maxSize_) {
+      return;
+    }
+    std::vector<uint8_t> marks(size_t(width_) * width_);
+    for (const point_t& p: node.seen) {
+      marks[index(p)] = 1;
+    }
+    std::vector<std::vector<point_t>> levels(maxSize_ + 1);
+    for (auto& untried: levels) {
+      untried.reserve(4 * maxSize_);
+    }
+    levels[node.cells.size()] = node.untried;
+    std::vector<TracedBoundary<grid>> boundaries(maxSize_ + 1);
+    boundaries[node.cells.size()] = node.boundary;
+    std::vector<point_t> cells = node.cells;
+    Shape<grid> scratch;
+    grow(cells, levels, boundaries, marks, scratch, visit);
+  }
+
+  // Writes the boundary of cells to child, given the boundary of cells
+  // without its last cell. Splices the parent's word when it is simple,
+  // and otherwise traces the shape, since filling a hole can make the
+  // boundary simple again. scratch is scratch space.
+  void childBoundary(const TracedBoundary<grid>& parent, const std::vector<point_t>& cells,
+                     TracedBoundary<grid>& child, Shape<grid>& scratch) const {
+    if (parent.simple) {
+      extendBoundary(parent, cells.back(), child);
+      return;
+    }
+    scratch.reset();
+    for (const point_t& p: cells) {
+      scratch.add(p);
+    }
+    traceBoundary(scratch, child);
+  }
+
+  // Returns whether cells, the cells of a fixed polyform found by the
+  // search, are the least of all images of the polyform under the grid's
+  // orientations, so that each free polyform is accepted once. Sets
+  // numFixed to the number of distinct fixed polyforms among the images.
+  // shape and image are scratch space.
+  bool isFreeCanonical(const std::vector<point_t>& cells, size_t& numFixed, Shape<grid>& shape,
+                       Shape<grid>& image) const {
+    shape.reset();
+    for (const point_t& p: cells) {
+      shape.add(p);
+    }
+    shape.complete();
+    size_t symmetries = 0;
+    for (size_t idx = 0; idx < grid::num_orientations; ++idx) {
+      image.reset(shape, grid::orientations[idx]);
+      image.untranslate();
+      int order = image.compare(shape);
+      if (order < 0) {
+        return false;
+      }
+      symmetries += (order == 0);
+    }
+    numFixed = grid::num_orientations / symmetries;
+    return true;
+  }
+
+ private:
+  // Cells lie within radius_ of the origin in both coordinates, since
+  // every edge neighbour step of the supported grids is at most 2.
+  size_t index(const point_t& p) const {
+    return size_t(p.x_ + radius_) * width_ + size_t(p.y_ + radius_);
+  }
+
+  // Adds the neighbours of c that are greater than root and not yet seen
+  // to the untried cells of node.
+  void addNeighbours(Node& node, const point_t& c, const point_t& root) const {
+    const point<int8_t>* vectors = grid::getEdgeNeighbourVectors(c);
+    for (size_t k = 0; k < grid::numEdgeNeighbours(c); ++k) {
+      point_t q = c + vectors[k];
+      if (root < q && std::find(node.seen.begin(), node.seen.end(), q) == node.seen.end()) {
+        node.seen.push_back(q);
+        node.untried.push_back(q);
+      }
+    }
+  }
+
+  // Adds each untried cell of the current level in turn. The child's
+  // untried cells are the ones this level hasn't taken yet plus the new
+  // neighbours of the added cell, so no polyform is reached twice.
+  template<typename Visit>
+  void grow(std::vector<point_t>& cells, std::vector<std::vector<point_t>>& levels,
+            std::vector<TracedBoundary<grid>>& boundaries, std::vector<uint8_t>& marks,
+            Shape<grid>& scratch, Visit& visit) const {
+    const point_t root = cells.front();
+    size_t depth = cells.size();
+    const std::vector<point_t>& untried = levels[depth];
+    for (size_t i = untried.size(); i-- > 0;) {
+      point_t c = untried[i];
+      cells.push_back(c);
+      visit(cells, boundaries[depth]);
+      if ((int)cells.size() < maxSize_) {
+        childBoundary(boundaries[depth], cells, boundaries[depth + 1], scratch);
+        std::vector<point_t>& next = levels[depth + 1];
+        next.assign(untried.begin(), untried.begin() + i);
+        const point<int8_t>* vectors = grid::getEdgeNeighbourVectors(c);
+        for (size_t k = 0; k < grid::numEdgeNeighbours(c); ++k) {
+          point_t q = c + vectors[k];
+          if (root < q && !marks[index(q)]) {
+            marks[index(q)] = 1;
+            next.push_back(q);
+          }
+        }
+        size_t inherited = i;
+        grow(cells, levels, boundaries, marks, scratch, visit);
+        for (size_t j = inherited; j < next.size(); ++j) {
+          marks[index(next[j])] = 0;
+        }
+      }
+      cells.pop_back();
+    }
+  }
+
+  int maxSize_;
+  int radius_;
+  int width_;
+};
+
+#endif // ENUMERATE_H
@@ -0,0 +1,105 @@
+#include "boundary_corpus.h"
+#include "enumerate.h"
+#include "hexgrid.h"
+#include "iamondgrid.h"
+#include "isohedral.h"
+#include "kitegrid.h"
+#include "ominogrid.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+// Counts of the free polyforms of one size.
+struct SizeCounts {
+  size_t free = 0;
+  size_t holey = 0;
+  size_t isohedral = 0;
+};
+
+// Enumerates the free polyforms of the grid up to maxSize on one thread
+// and checks the simple ones, as isohedral_e2e --enumerate does.
+template<typename grid>
+vector<SizeCounts> enumerate(GridType type, int maxSize) {
+  PolyformEnumerator<grid> enumerator(maxSize);
+  vector<SizeCounts> counts(maxSize + 1);
+  BoundaryCorpus words;
+  vector<size_t> sizes;
+  Shape<grid> shape;
+  Shape<grid> image;
+  TracedBoundary<grid> boundary;
+  auto visit = [&](const vector<typename grid::point_t>& cells, const TracedBoundary<grid>& parent) {
+    size_t numFixed;
+    if (!enumerator.isFreeCanonical(cells, numFixed, shape, image)) {
+      return;
+    }
+    ++counts[cells.size()].free;
+    enumerator.childBoundary(parent, cells, boundary, shape);
+    if (!boundary.simple) {
+      ++counts[cells.size()].holey;
+    } else if (fits_checker(boundary.word.size()) && words.push_back(boundary.word)) {
+      sizes.push_back(cells.size());
+    }
+  };
+  for (const auto& node: enumerator.split(1, visit)) {
+    enumerator.search(node, visit);
+  }
+  vector<bool> results = IsohedralChecker::forGrid(type).check_batch(words);
+  for (size_t i = 0; i < results.size(); ++i) {
+    counts[sizes[i]].isohedral += results[i];
+  }
+  return counts;
+}
+
+// Compares the counts of sizes 1 and up with the expected ones.
+bool matches(const string& name, const vector<SizeCounts>& counts, const vector<size_t>& free,
+             const vector<size_t>& holey, const vector<size_t>& isohedral) {
+  bool ok = true;
+  for (size_t size = 1; size < counts.size(); ++size) {
+    const SizeCounts& c = counts[size];
+    if (c.free != free[size - 1] || c.holey != holey[size - 1] ||
+        (!isohedral.empty() && c.isohedral != isohedral[size - 1])) {
+      cout << name << " of size " << size << ": " << c.free << " free, " << c.holey << " holey, "
+           << c.isohedral << " isohedral.\n";
+      ok = false;
+    }
+  }
+  return ok;
+}
+
+int main() {
+  // Free polyform counts are OEIS A000105, A000228, A000577 and A057786.
+  // Every polyomino and polyiamond up to size 6 tiles isohedrally.
+  if (matches("Polyominoes", enumerate<OminoGrid<int>>(OMINO, 8),
+              {1, 1, 2, 5, 12, 35, 108, 369}, {0, 0, 0, 0, 0, 0, 1, 6},
+              {1, 1, 2, 5, 12, 35, 104, 342})) {
+    cout << "Polyomino enumeration test case passed.\n";
+  } else {
+    cout << "Polyomino enumeration test failed.\n";
+  }
+
+  if (matches("Polyhexes", enumerate<HexGrid<int>>(HEX, 7),
+              {1, 1, 3, 7, 22, 82, 333}, {0, 0, 0, 0, 0, 1, 2},
+              {1, 1, 3, 7, 22, 76, 290})) {
+    cout << "Polyhex enumeration test case passed.\n";
+  } else {
+    cout << "Polyhex enumeration test failed.\n";
+  }
+
+  if (matches("Polyiamonds", enumerate<IamondGrid<int>>(IAMOND, 7),
+              {1, 1, 1, 3, 4, 12, 24}, {0, 0, 0, 0, 0, 0, 0},
+              {1, 1, 1, 3, 4, 12, 23})) {
+    cout << "Polyiamond enumeration test case passed.\n";
+  } else {
+    cout << "Polyiamond enumeration test failed.\n";
+  }
+
+  if (matches("Polykites", enumerate<KiteGrid<int>>(KITE, 7),
+              {1, 2, 4, 10, 27, 85, 262}, {0, 0, 0, 0, 0, 1, 4}, {})) {
+    cout << "Polykite enumeration test case passed.\n";
+  } else {
+    cout << "Polykite enumeration test failed.\n";
+  }
+}
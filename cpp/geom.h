@@ -1,7 +1,27 @@
 #ifndef GEOM_H
 #define GEOM_H
 
-#include <iostream>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+
+// Finalizer from splitmix64.  Spreads the bits of a packed key so that
+// nearby lattice points land in unrelated buckets of a hash table.
+inline size_t hash_mix( uint64_t h )
+{
+	h ^= h >> 30;
+	h *= 0xbf58476d1ce4e5b9ULL;
+	h ^= h >> 27;
+	h *= 0x94d049bb133111ebULL;
+	h ^= h >> 31;
+	return static_cast<size_t>( h );
+}
+
+inline size_t hash_combine( size_t seed, uint64_t v )
+{
+	return hash_mix( seed ^ (v + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)) );
+}
 
 template<typename coord>
 class point
@@ -87,6 +107,24 @@ public:
 		return *this;
 	}
 
+	// Both coordinates in a single 64-bit key, x in the high word.
+	// Only meaningful for integer coordinates.
+	uint64_t pack() const
+	{
+		return (uint64_t( uint32_t( int32_t( x_ ) ) ) << 32)
+			| uint64_t( uint32_t( int32_t( y_ ) ) );
+	}
+	static point<coord> unpack( uint64_t key )
+	{
+		return { coord( int32_t( uint32_t( key >> 32 ) ) ),
+				 coord( int32_t( uint32_t( key ) ) ) };
+	}
+
+	size_t hash() const
+	{
+		return hash_mix( pack() );
+	}
+
 	coord x_;
 	coord y_;
 };
@@ -223,17 +261,17 @@ public:
 		return a_*e_ - b_*d_;
 	}
 
-	/*size_t hash() const
+	size_t hash() const
 	{
 		size_t res = 0;
-		boost::hash_combine( res, a_ );
-		boost::hash_combine( res, b_ );
-		boost::hash_combine( res, c_ );
-		boost::hash_combine( res, d_ );
-		boost::hash_combine( res, e_ );
-		boost::hash_combine( res, f_ );
+		res = hash_combine( res, uint64_t( int64_t( a_ ) ) );
+		res = hash_combine( res, uint64_t( int64_t( b_ ) ) );
+		res = hash_combine( res, uint64_t( int64_t( c_ ) ) );
+		res = hash_combine( res, uint64_t( int64_t( d_ ) ) );
+		res = hash_combine( res, uint64_t( int64_t( e_ ) ) );
+		res = hash_combine( res, uint64_t( int64_t( f_ ) ) );
 		return res;
-	}*/
+	}
 
 	coord a_;
 	coord b_;
@@ -243,5 +281,32 @@ public:
 	coord f_;
 };
 
+template<typename coord>
+inline size_t hash_value( const xform<coord>& T )
+{
+	return T.hash();
+}
+
+namespace std
+{
+	template<typename coord>
+	struct hash<point<coord>>
+	{
+		size_t operator()( const point<coord>& p ) const
+		{
+			return p.hash();
+		}
+	};
+
+	template<typename coord>
+	struct hash<xform<coord>>
+	{
+		size_t operator()( const xform<coord>& T ) const
+		{
+			return T.hash();
+		}
+	};
+}
+
 #endif // !GEOM_H
 
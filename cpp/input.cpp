@@ -0,0 +1,49 @@
+#include "input.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+MappedFile::~MappedFile() {
+  close();
+}
+
+bool MappedFile::open(const std::string& path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  if (!S_ISREG(st.st_mode)) {
+    ::close(fd);
+    return false;
+  }
+  size_ = st.st_size;
+  if (size_ > 0) {
+    void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      ::close(fd);
+      size_ = 0;
+      return false;
+    }
+    madvise(map, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(map);
+  }
+  ::close(fd);
+  return true;
+}
+
+void MappedFile::close() {
+  if (data_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+  data_ = nullptr;
+  size_ = 0;
+}
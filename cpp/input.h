@@ -0,0 +1,146 @@
+#ifndef INPUT_H
+#define INPUT_H
+
+#include "shape.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+// A read-only memory map of a whole regular file. Pipes and devices
+// can't be mapped; open() fails for them and callers stream them instead.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile();
+
+  bool open(const std::string& path);
+  void close();
+
+  const char* begin() const { return data_; }
+  const char* end() const { return data_ + size_; }
+  size_t size() const { return size_; }
+
+ private:
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+// Returns the end of the line starting at p: the position of its '\n',
+// or end for an unterminated last line.
+inline const char* find_line_end(const char* p, const char* end) {
+  const void* eol = memchr(p, '\n', end - p);
+  return eol ? static_cast<const char*>(eol) : end;
+}
+
+// Splits [begin, end) into parts byte ranges of roughly equal size whose
+// boundaries fall just after a newline, so that no line is split. Returns
+// the parts+1 boundaries; some ranges may be empty for short inputs.
+inline std::vector<const char*> split_at_lines(const char* begin, const char* end, size_t parts) {
+  std::vector<const char*> bounds(parts + 1, end);
+  bounds[0] = begin;
+  size_t size = end - begin;
+  for (size_t k = 1; k < parts; ++k) {
+    const char* p = std::max(begin + size * k / parts, bounds[k - 1]);
+    if (p > begin && p < end && p[-1] != '\n') {
+      p = find_line_end(p, end);
+      p += (p < end);
+    }
+    bounds[k] = p;
+  }
+  return bounds;
+}
+
+// Outcome of parsing one line of gen output.
+enum ParseStatus {
+  PARSE_OK = 0,
+  PARSE_EMPTY = 1,
+  PARSE_ODD = 2,
+  // A token after the tag isn't an integer, or is out of range.
+  PARSE_BAD_NUMBER = 3
+};
+
+// Describes a status whose line can't be used, or returns nullptr.
+inline const char* parse_error(ParseStatus status) {
+  switch (status) {
+    case PARSE_ODD:
+      return "Odd number of integers in line.";
+    case PARSE_BAD_NUMBER:
+      return "Malformed or out of range integer in line.";
+    default:
+      return nullptr;
+  }
+}
+
+// Parses one line [line, eol) of heesch-sat gen output into shape, which
+// is emptied first and otherwise reused. A line is a tag token followed
+// by pairs of cell coordinates. Integers are scanned in place, so no
+// strings or temporary vectors are allocated.
+template <typename grid>
+ParseStatus parse_shape_line(const char* line, const char* eol, Shape<grid>& shape) {
+  using coord_t = typename grid::coord_t;
+
+  shape.reset();
+  const char* p = line;
+  auto skip_space = [&]() {
+    while (p < eol && (*p == ' ' || *p == '\t' || *p == '\r')) {
+      ++p;
+    }
+  };
+
+  // Skip the tag.
+  skip_space();
+  if (p == eol) {
+    return PARSE_EMPTY;
+  }
+  while (p < eol && *p != ' ' && *p != '\t') {
+    ++p;
+  }
+
+  int coords[2];
+  int num_coords = 0;
+  while (true) {
+    skip_space();
+    if (p == eol) {
+      break;
+    }
+    bool negative = (*p == '-');
+    p += negative;
+    const char* digits = p;
+    int value = 0;
+    unsigned digit;
+    while (p < eol && (digit = unsigned(*p - '0')) < 10) {
+      if (value > (int(std::numeric_limits<coord_t>::max()) - int(digit)) / 10) {
+        return PARSE_BAD_NUMBER;
+      }
+      value = 10 * value + int(digit);
+      ++p;
+    }
+    if (p == digits || (p < eol && *p != ' ' && *p != '\t' && *p != '\r')) {
+      return PARSE_BAD_NUMBER;
+    }
+    coords[num_coords] = negative ? -value : value;
+    if (++num_coords == 2) {
+      shape.add(coord_t(coords[0]), coord_t(coords[1]));
+      num_coords = 0;
+    }
+  }
+  return (num_coords == 0) ? PARSE_OK : PARSE_ODD;
+}
+
+// Parses the whole of text as a number, as given in a command line
+// option. Returns false for an empty or malformed value, trailing
+// characters, a sign on an unsigned type, or a value out of range.
+template <typename T>
+bool parse_number(const std::string& text, T& value) {
+  const char* end = text.data() + text.size();
+  auto [p, error] = std::from_chars(text.data(), end, value);
+  return !text.empty() && error == std::errc() && p == end;
+}
+
+#endif // INPUT_H
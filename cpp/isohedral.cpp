@@ -1,10 +1,11 @@
 #include "boundary.h"
 #include "isohedral.h"
+#include "letter_kernels.h"
+#include "phase_timer.h"
 
 #include <algorithm>
 #include <array>
 #include <cassert>
-#include <iostream>
 #include <map>
 #include <set>
 #include <string>
@@ -13,18 +14,6 @@
 
 using namespace std;
 
-void printFactor(const Factor& f) {
-  cout << f.first << " " << f.second << "\n";
-}
-
-int longest_match(const boundaryword& S1, const boundaryword& S2, size_t ub) {
-  int i = 0;
-  while (i < min({S1.size(), S2.size(), ub}) && S1[i] == S2[i]) {
-    ++i;
-  }
-  return i;
-}
-
 bool is_double_palindrome(const Factor& F, const vector<vector<Factor>>& palindrome_factor_starts, const vector<vector<Factor>>& palindrome_factor_ends, int n) {
   int F_len = F.second - F.first + 1 + n * (F.second < F.first);
   for (const auto& F1: palindrome_factor_starts[F.first]) {
@@ -42,51 +31,139 @@ bool is_double_palindrome(const Factor& F, const vector<vector<Factor>>& palindr
   return false;
 }
 
-bool IsohedralChecker::is_reflect_square_factor(const boundaryword& P, int i, int j, int theta) {
+// Returns the length of the longest common prefix of two runs of packed
+// letters, capped at ub.
+int longest_match(const uint8_t* a, const uint8_t* b, int ub) {
+  return (ub > 0) ? letter_kernels().common_prefix(a, b, ub) : 0;
+}
+
+LetterTables::LetterTables(const LetterMap& complement_map, const LetterMap& ccw_map, const LetterMap& cw_map,
+                           const map<int, LetterMap>& refl_map) {
+  auto freeze_map = [](const LetterMap& m, array<uint8_t, 256>& table) {
+    table.fill(0);
+    for (auto& p: m) {
+      table[pack(p.first)] = pack(p.second);
+    }
+  };
+  for (auto& p: complement_map) {
+    letters.push_back(p.first);
+  }
+  freeze_map(complement_map, complement);
+  freeze_map(ccw_map, ccw);
+  freeze_map(cw_map, cw);
+  for (auto& p: refl_map) {
+    refl.emplace_back(p.first, array<uint8_t, 256>());
+    freeze_map(p.second, refl.back().second);
+  }
+}
+
+IsohedralChecker::IsohedralChecker() : IsohedralChecker(forGrid(OMINO)) {}
+
+IsohedralChecker::IsohedralChecker(int min_angle, const LetterMap& complement, const LetterMap& ccw,
+                                   const LetterMap& cw, const map<int, LetterMap>& refl)
+    : minAngle(min_angle), tables(complement, ccw, cw, refl) {}
+
+TransformBank IsohedralChecker::transform_bank(const boundaryword& P) const {
+  ScopedPhase timer(PHASE_TRANSFORM_BANK);
+  TransformBank bank;
   int n = P.size();
+  bank.n = n;
+  // Writes the n letters of view out twice.
+  auto store = [&](vector<uint8_t>& copy, const CyclicView& view) {
+    copy.resize(2 * n);
+    for (int k = 0; k < n; ++k) {
+      copy[k] = copy[k + n] = view[k];
+    }
+  };
+
+  bank.forward.resize(2 * n);
+  for (int k = 0; k < n; ++k) {
+    bank.forward[k] = bank.forward[k + n] = LetterTables::pack(P[k]);
+  }
+  const uint8_t* word = bank.forward.data();
+  store(bank.reverse, CyclicView(word, n, n - 1, -1));
+  store(bank.reverse_complement, CyclicView(word, n, n - 1, -1, &tables.complement));
+  bank.rotated.push_back(bank.forward);
+  for (int k = 1; k < 360 / minAngle; ++k) {
+    vector<uint8_t> turned;
+    store(turned, CyclicView(bank.rotated.back().data(), n, 0, 1, &tables.ccw));
+    bank.rotated.push_back(std::move(turned));
+  }
+  for (auto& p: tables.refl) {
+    store(bank.reflected[p.first], CyclicView(word, n, 0, 1, &p.second));
+  }
+  return bank;
+}
+
+bool IsohedralChecker::is_reflect_square_factor(const TransformBank& bank, int i, int j, int theta) const {
+  int n = bank.n;
   int l = j - i + 1 + n * (j < i);
   if (l % 2 != 0) {
     return false;
   }
   l /= 2;
-  boundaryword reflected;
-
-  for (auto& c: boundaryword(P.begin() + ((i+l)%n), P.end())) {
-    reflected.push_back(REFL[theta][c]);
-  }
-  for (auto& c: P) {
-    reflected.push_back(REFL[theta][c]);
-  }
-  return (l == longest_match(slice(P, i) + P, reflected, l+1));
+  return (l == longest_match(bank.from(bank.forward, i), bank.from(bank.reflected.at(theta), i + l), l+1));
 }
 
-boundaryword IsohedralChecker::inv_comp(const boundaryword& S) {
+boundaryword IsohedralChecker::inv_comp(const boundaryword& S) const {
   boundaryword result;
   result.reserve(S.size());
 
   for (auto it = S.rbegin(); it != S.rend(); ++it) {
-    result.push_back(COMPLEMENT[*it]);
+    result.push_back(LetterTables::apply(tables.complement, *it));
   }
   return result;
 }
 
-pair<int, int> IsohedralChecker::iteratedCcw(pair<int, int> dir, int numIters) {
+boundaryword IsohedralChecker::canonical_form(const boundaryword& P) const {
+  ScopedPhase timer(PHASE_CANONICAL);
+  int n = P.size();
+  boundaryword best;
+  boundaryword rotated(n);
+  auto consider = [&](const boundaryword& image) {
+    int r = least_rotation(image);
+    rotate_copy(image.begin(), image.begin() + r, image.end(), rotated.begin());
+    if (best.empty() || rotated < best) {
+      best = rotated;
+    }
+  };
+
+  boundaryword image = P;
+  for (int k = 0; k < 360 / minAngle; ++k) {
+    consider(image);
+    for (auto& c: image) {
+      c = LetterTables::apply(tables.ccw, c);
+    }
+  }
+  for (auto& p: tables.refl) {
+    for (int i = 0; i < n; ++i) {
+      image[i] = LetterTables::apply(tables.complement, LetterTables::apply(p.second, P[n - 1 - i]));
+    }
+    consider(image);
+  }
+  return best;
+}
+
+pair<int, int> IsohedralChecker::iteratedCcw(pair<int, int> dir, int numIters) const {
   if (numIters < 0) return {0, 0};
   for (int i = 0; i < numIters; ++i) {
-    dir = CCW[dir];
+    dir = LetterTables::apply(tables.ccw, dir);
   }
   return dir;
 }
 
-FactorArray<2*MAX_BND> IsohedralChecker::admissible_mirror_factors(const boundaryword& P) {
-  int n = P.size();
+FactorArray<2*MAX_BND> IsohedralChecker::admissible_mirror_factors(const TransformBank& bank) const {
+  ScopedPhase timer(PHASE_MIRROR_FACTORS);
+  int n = bank.n;
+  const vector<uint8_t>& P = bank.forward;
+  const vector<uint8_t>& P_hat = bank.reverse_complement;
   FactorArray<2*MAX_BND> factors;
   size_t factor_idx = 0;
 
   // Compute admissible mirror factors starting between letter pairs
   for (int i = 0; i < n; ++i) {
-    int l = longest_match(inv_comp(P + slice(P, 0, i)), slice(P, (i + n / 2) %n) + P, n/4);
-    int r = longest_match(slice(P, i) + P, inv_comp(P + slice(P, 0, (i + n/2) %n)), n/4);
+    int l = longest_match(bank.back_from(P_hat, i - 1), bank.from(P, i + n/2), n/4);
+    int r = longest_match(bank.from(P, i), bank.back_from(P_hat, i + n/2 - 1), n/4);
     if (l == r && r > 0) {
       auto start = (i - l + n) % n;
       auto end = (i - 1 + r + n) % n;
@@ -96,9 +173,9 @@ FactorArray<2*MAX_BND> IsohedralChecker::admissible_mirror_factors(const boundar
 
   // Compute admissible mirror factors starting in middle of a letter
   for (int i = 0; i < n; ++i) {
-    if (P[i] == COMPLEMENT[P[(i + n/2) % n]]) {
-      int l = longest_match(inv_comp(P + slice(P, 0, i)), slice(P, (i + n/2 + 1) %n) + P, (n - 2)/4);
-      int r = longest_match(slice(P, (i+1)%n) + P, inv_comp(P + slice(P, 0, (i + n/2)%n)), (n-2)/4);
+    if (P[i] == *bank.back_from(P_hat, i + n/2)) {
+      int l = longest_match(bank.back_from(P_hat, i - 1), bank.from(P, i + n/2 + 1), (n - 2)/4);
+      int r = longest_match(bank.from(P, i + 1), bank.back_from(P_hat, i + n/2 - 1), (n-2)/4);
       if (l == r) {
         int start = (i - l + n) %n;
         int end = (i + r) % n;
@@ -110,15 +187,18 @@ FactorArray<2*MAX_BND> IsohedralChecker::admissible_mirror_factors(const boundar
   return factors;
 }
 
-FactorPairArray<MAX_BND*MAX_BND> IsohedralChecker::admissible_gapped_mirror_factor_pairs(const boundaryword& P) {
-  int n = P.size();
+FactorPairArray<MAX_BND*MAX_BND> IsohedralChecker::admissible_gapped_mirror_factor_pairs(const TransformBank& bank) const {
+  ScopedPhase timer(PHASE_GAPPED_MIRROR_FACTORS);
+  int n = bank.n;
+  const vector<uint8_t>& P = bank.forward;
+  const vector<uint8_t>& P_hat = bank.reverse_complement;
   FactorPairArray<MAX_BND*MAX_BND> factor_pairs;
   size_t factor_idx = 0;
   // Compute admissible mirror factors starting between letter pairs
   for (int i = 0; i < n; ++i) {
     for (int j = i + 1; j < n; ++j) {
-      int l = longest_match(inv_comp(P + slice(P, 0, i)), slice(P, j)+ P, (i + n - j) / 2);
-      int r = longest_match(slice(P, i) + P, inv_comp(P + slice(P, 0, j)), (j - i) / 2);
+      int l = longest_match(bank.back_from(P_hat, i - 1), bank.from(P, j), (i + n - j) / 2);
+      int r = longest_match(bank.from(P, i), bank.back_from(P_hat, j - 1), (j - i) / 2);
 
       if (l == r && r > 0) {
         factor_pairs[factor_idx++] = {make_pair((i-l+n)%n, (i-1+r+n)%n), make_pair((j-l+n)%n, (j-1+r+n)%n)};
@@ -129,9 +209,9 @@ FactorPairArray<MAX_BND*MAX_BND> IsohedralChecker::admissible_gapped_mirror_fact
   // Compute admissible mirror factors starting in the middle of a letter
   for (int i = 0; i < n; ++i) {
     for (int j = i + 1; j < n; ++j) {
-      if (P[i] == COMPLEMENT[P[j]]) {
-        int l = longest_match(inv_comp(P + slice(P, 0, i)), slice(P, (j + 1) % n) + P, (i + n - j - 1)/2);
-        int r = longest_match(slice(P, (i+1)%n) + P, inv_comp(P + slice(P, 0, j)), (j-i-1)/2);
+      if (P[i] == *bank.back_from(P_hat, j)) {
+        int l = longest_match(bank.back_from(P_hat, i - 1), bank.from(P, j + 1), (i + n - j - 1)/2);
+        int r = longest_match(bank.from(P, i + 1), bank.back_from(P_hat, j - 1), (j-i-1)/2);
         if (l == r) {
           factor_pairs[factor_idx++] = {make_pair((i-l+n)%n, (i+r)%n), make_pair((j-l+n)%n, (j+r)%n)};
         }
@@ -142,32 +222,27 @@ FactorPairArray<MAX_BND*MAX_BND> IsohedralChecker::admissible_gapped_mirror_fact
   return factor_pairs;
 }
 
-FactorArray<2*MAX_BND> IsohedralChecker::admissible_rotadrome_factors(const boundaryword& P, int theta) {
-  int n = P.size();
+FactorArray<2*MAX_BND> IsohedralChecker::admissible_rotadrome_factors(const TransformBank& bank, int theta) const {
+  ScopedPhase timer(PHASE_ROTADROME_FACTORS);
+  int n = bank.n;
   theta = 180 - theta;
-  int numCcw = (theta % minAngle == 0) ? theta / minAngle : -1;
   FactorArray<2*MAX_BND> factors;
   size_t factor_idx = 0;
 
-  for (int i = 0; i < n; ++i) {
-    boundaryword firstString = P + slice(P, 0, i);
-    reverse(firstString.begin(), firstString.end());
-    boundaryword rotString(n + (n - i), {0, 0});
-    boundaryword secondString = slice(P, i)+ P;
-    for (int i = 0; i < secondString.size(); ++i) {
-      rotString[i] = iteratedCcw(secondString[i], numCcw);
-    }
-    int l = longest_match(firstString, rotString, n/2);
-    if (l > 0) {
-      factors[factor_idx++] = make_pair((i-l+n)%n, (i-1+l)%n);
+  // Without a rotation by theta in the grid there are no rotadromes.
+  if (theta % minAngle == 0) {
+    const vector<uint8_t>& rotated = bank.rotated[theta / minAngle];
+    for (int i = 0; i < n; ++i) {
+      int l = longest_match(bank.back_from(bank.reverse, i - 1), bank.from(rotated, i), n/2);
+      if (l > 0) {
+        factors[factor_idx++] = make_pair((i-l+n)%n, (i-1+l)%n);
+      }
     }
   }
   // Compute admissible palindrome factors starting in middle of a letter
   if (theta == 0) {
     for (int i = 0; i < n; ++i) {
-      boundaryword firstString = P + slice(P, 0, i);
-      reverse(firstString.begin(), firstString.end());
-      int l = longest_match(firstString, slice(P, (i+1)%n) + P, n/2);
+      int l = longest_match(bank.back_from(bank.reverse, i - 1), bank.from(bank.forward, i + 1), n/2);
       factors[factor_idx++] = make_pair((i-l+n)%n, (i+l)%n);
     }
   }
@@ -175,8 +250,9 @@ FactorArray<2*MAX_BND> IsohedralChecker::admissible_rotadrome_factors(const boun
   return factors;
 }
 
-FactorArray<MAX_BND*MAX_BND> IsohedralChecker::admissible_reflect_square_factors(const boundaryword& P) {
-  int n = P.size();
+FactorArray<MAX_BND*MAX_BND> IsohedralChecker::admissible_reflect_square_factors(const TransformBank& bank) const {
+  ScopedPhase timer(PHASE_REFLECT_SQUARE_FACTORS);
+  int n = bank.n;
 
   FactorArray<MAX_BND*MAX_BND> factors;
   size_t factor_idx = 0;
@@ -185,9 +261,9 @@ FactorArray<MAX_BND*MAX_BND> IsohedralChecker::admissible_reflect_square_factors
       if (j == i) {
         continue;
       }
-      for (auto &p: REFL) {
+      for (auto &p: bank.reflected) {
         int theta = p.first;
-        if (is_reflect_square_factor(P, i, j, theta)) {
+        if (is_reflect_square_factor(bank, i, j, theta)) {
           factors[factor_idx++] = {i, j};
         }
       }
@@ -197,20 +273,15 @@ FactorArray<MAX_BND*MAX_BND> IsohedralChecker::admissible_reflect_square_factors
   return factors;
 }
 
-vector<pair<Factor, Factor>> IsohedralChecker::admissible_gapped_reflect_square_factor_pairs(const boundaryword& P, int theta) {
-  int n = P.size();
+vector<pair<Factor, Factor>> IsohedralChecker::admissible_gapped_reflect_square_factor_pairs(const TransformBank& bank, int theta) const {
+  ScopedPhase timer(PHASE_GAPPED_REFLECT_SQUARE_FACTORS);
+  int n = bank.n;
+  const vector<uint8_t>& reflected = bank.reflected.at(theta);
   vector<pair<Factor, Factor>> factor_pairs;
   for (int i = 0; i < n; ++i) {
     for (int j = i + 1; j < n; ++j) {
       int d = min(j - i + n * (j < i), i - j + n * (i < j));
-      boundaryword reflected;
-      for (auto& c: slice(P, j)) {
-        reflected.push_back(REFL[theta][c]);
-      }
-      for (auto& c: P) {
-        reflected.push_back(REFL[theta][c]);
-      }
-      int l = longest_match(slice(P, i) + P, reflected, d+1);
+      int l = longest_match(bank.from(bank.forward, i), bank.from(reflected, j), d+1);
       if (1 <= l && l <= d) {
         factor_pairs.push_back({{i, (i+l-1+n)%n}, {j, (j+l-1+n)%n}});
       }
@@ -219,7 +290,8 @@ vector<pair<Factor, Factor>> IsohedralChecker::admissible_gapped_reflect_square_
   return factor_pairs;
 }
 
-bool IsohedralChecker::has_translation_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& mirror_factors) {
+bool IsohedralChecker::has_translation_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& mirror_factors) const {
+  ScopedPhase timer(PHASE_TRANSLATION);
   // Looking for factorization A B C A_hat B_hat C_hat 
   // where A_hat is inverse complement of A.
   int n = P.size();
@@ -251,7 +323,8 @@ bool IsohedralChecker::has_translation_tiling(const boundaryword& P, const Facto
   return false;
 }
 
-bool IsohedralChecker::has_half_turn_tiling(const boundaryword& P, const FactorPairArray<MAX_BND*MAX_BND>& mirror_factor_pairs, const FactorArray<2*MAX_BND>& palin_factors) {
+bool IsohedralChecker::has_half_turn_tiling(const boundaryword& P, const FactorPairArray<MAX_BND*MAX_BND>& mirror_factor_pairs, const FactorArray<2*MAX_BND>& palin_factors) const {
+  ScopedPhase timer(PHASE_HALF_TURN);
   // Looking for factorization A B C hat(A) D E
   // where B, C, D, E are palindromes
   int n = P.size();
@@ -294,7 +367,8 @@ bool IsohedralChecker::has_half_turn_tiling(const boundaryword& P, const FactorP
   return false;
 }
 
-bool IsohedralChecker::has_quarter_turn_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& ninety_factors, const FactorArray<2*MAX_BND>& palin_factors) {
+bool IsohedralChecker::has_quarter_turn_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& ninety_factors, const FactorArray<2*MAX_BND>& palin_factors) const {
+  ScopedPhase timer(PHASE_QUARTER_TURN);
   // Looking for factorization A B C 
   // where A is a palindrome and B,C are 90-dromes.
   int n = P.size();
@@ -334,7 +408,8 @@ bool IsohedralChecker::has_quarter_turn_tiling(const boundaryword& P, const Fact
   return false;
 }
 
-bool IsohedralChecker::has_type_1_reflection_tiling(const boundaryword& P, const FactorArray<MAX_BND*MAX_BND>& reflect_square_factors, const FactorPairArray<MAX_BND*MAX_BND>& mirror_factor_pairs) {
+bool IsohedralChecker::has_type_1_reflection_tiling(const boundaryword& P, const FactorArray<MAX_BND*MAX_BND>& reflect_square_factors, const FactorPairArray<MAX_BND*MAX_BND>& mirror_factor_pairs) const {
+  ScopedPhase timer(PHASE_TYPE_1_REFLECTION);
   // Looking for factorization A B f_theta(A) A_hat C f_phi(C)
   // for some angles theta, phi
   int n = P.size();
@@ -365,13 +440,14 @@ bool IsohedralChecker::has_type_1_reflection_tiling(const boundaryword& P, const
   return false;
 }
 
-bool IsohedralChecker::has_type_2_reflection_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& mirror_factors) {
+bool IsohedralChecker::has_type_2_reflection_tiling(const TransformBank& bank, const FactorArray<2*MAX_BND>& mirror_factors) const {
+  ScopedPhase timer(PHASE_TYPE_2_REFLECTION);
   // Looking for factorization A B C A_hat f_theta(C) f_theta(B)
-  int n = P.size();
-  for (auto& p: REFL) {
+  int n = bank.n;
+  for (auto& p: bank.reflected) {
     int theta = p.first;
     map<Factor, vector<pair<Factor, Factor>>> reflect_factor_tips;
-    for (auto& p: admissible_gapped_reflect_square_factor_pairs(P, theta)) {
+    for (auto& p: admissible_gapped_reflect_square_factor_pairs(bank, theta)) {
       Factor f = p.first;
       Factor cf = p.second;
       reflect_factor_tips[make_pair(f.first, cf.second)].push_back({f, cf});
@@ -417,7 +493,8 @@ bool IsohedralChecker::has_type_2_reflection_tiling(const boundaryword& P, const
   return false;
 }
 
-bool IsohedralChecker::has_type_1_half_turn_reflection_tiling(const boundaryword& P, const FactorPairArray<MAX_BND*MAX_BND>& partial_mirror_factor_pairs, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<MAX_BND*MAX_BND>& reflect_square_factors) {
+bool IsohedralChecker::has_type_1_half_turn_reflection_tiling(const boundaryword& P, const FactorPairArray<MAX_BND*MAX_BND>& partial_mirror_factor_pairs, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<MAX_BND*MAX_BND>& reflect_square_factors) const {
+  ScopedPhase timer(PHASE_TYPE_1_HALF_TURN_REFLECTION);
   // Looking for factorization A B C A_Hat D f_theta(D)
   int n = P.size();
   // Factorization is not symmetric so we need both orderings of each pair.
@@ -463,14 +540,15 @@ bool IsohedralChecker::has_type_1_half_turn_reflection_tiling(const boundaryword
   return false;
 }
 
-bool IsohedralChecker::has_type_2_half_turn_reflection_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors) {
+bool IsohedralChecker::has_type_2_half_turn_reflection_tiling(const TransformBank& bank, const FactorArray<2*MAX_BND>& palin_factors) const {
+  ScopedPhase timer(PHASE_TYPE_2_HALF_TURN_REFLECTION);
   // Looking for factorization A B C D f_theta(B) f_phi(D)
   // where A, C are palindromes and theta - phi = +-90
-  int n = P.size();
+  int n = bank.n;
   map<int, vector<pair<Factor, Factor>>> reflect_factor_pairs;
-  for (auto& p: REFL) {
+  for (auto& p: bank.reflected) {
     int theta = p.first;
-    reflect_factor_pairs[theta] = admissible_gapped_reflect_square_factor_pairs(P, theta);
+    reflect_factor_pairs[theta] = admissible_gapped_reflect_square_factor_pairs(bank, theta);
     // Double up, both for tips and for f1, cf1 iterating since B, refl(B) are not symmetric
     vector<pair<Factor, Factor>> reversed_pairs;
     for (auto& fp: reflect_factor_pairs[theta]) {
@@ -480,7 +558,7 @@ bool IsohedralChecker::has_type_2_half_turn_reflection_tiling(const boundaryword
   }
 
   vector<pair<int, int>> theta_pairs;
-  for (auto&p: REFL){
+  for (auto&p: bank.reflected){
     int theta = p.first;
     int perpendicular = (theta > 0) ? theta - 90: theta + 90;
     theta_pairs.push_back({theta, perpendicular});
@@ -560,7 +638,8 @@ bool IsohedralChecker::has_type_2_half_turn_reflection_tiling(const boundaryword
   return false;
 }
 
-bool IsohedralChecker::has_case_7_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& onetwenty_factors) {
+bool IsohedralChecker::has_case_7_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& onetwenty_factors) const {
+  ScopedPhase timer(PHASE_CASE_7);
   // Looking for factorization A f_120(A) B f_120(B) C t_120(C)
   int n = P.size();
   vector<set<Factor>> factor_starts(n);
@@ -588,7 +667,8 @@ bool IsohedralChecker::has_case_7_tiling(const boundaryword& P, const FactorArra
   return false;
 }
 
-bool IsohedralChecker::has_case_8a_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<2*MAX_BND>& sixty_factors, const FactorArray<2*MAX_BND>& onetwenty_factors) {
+bool IsohedralChecker::has_case_8a_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<2*MAX_BND>& sixty_factors, const FactorArray<2*MAX_BND>& onetwenty_factors) const {
+  ScopedPhase timer(PHASE_CASE_8A);
   // Looking for factorization A f_60(A) B f_120(B) C
   // where C is palindrome.
   int n = P.size();
@@ -640,7 +720,8 @@ bool IsohedralChecker::has_case_8a_tiling(const boundaryword& P, const FactorArr
   return false;
 }
 
-bool IsohedralChecker::has_case_8b_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<2*MAX_BND>& sixty_factors, const FactorArray<2*MAX_BND>& onetwenty_factors) {
+bool IsohedralChecker::has_case_8b_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<2*MAX_BND>& sixty_factors, const FactorArray<2*MAX_BND>& onetwenty_factors) const {
+  ScopedPhase timer(PHASE_CASE_8B);
   // Looking for factorization A f_60(A) B C f_120(C)
   // where B is a palindrome.
   int n = P.size();
@@ -694,40 +775,42 @@ bool IsohedralChecker::has_case_8b_tiling(const boundaryword& P, const FactorArr
 }
 
 
-bool IsohedralChecker::has_isohedral_tiling(const boundaryword &P) {
-  FactorPairArray<MAX_BND*MAX_BND> mirror_factor_pairs = admissible_gapped_mirror_factor_pairs(P);
-  FactorArray<2*MAX_BND> palin_factors = admissible_rotadrome_factors(P, 180);
+bool IsohedralChecker::has_isohedral_tiling(const boundaryword &P) const {
+  assert(fits_checker(P.size()));
+  TransformBank bank = transform_bank(P);
+  FactorPairArray<MAX_BND*MAX_BND> mirror_factor_pairs = admissible_gapped_mirror_factor_pairs(bank);
+  FactorArray<2*MAX_BND> palin_factors = admissible_rotadrome_factors(bank, 180);
   if (has_half_turn_tiling(P, mirror_factor_pairs, palin_factors)) return true;
 
-  FactorArray<2*MAX_BND> mirror_factors = admissible_mirror_factors(P);
+  FactorArray<2*MAX_BND> mirror_factors = admissible_mirror_factors(bank);
   if (has_translation_tiling(P, mirror_factors)) return true;
   
-  FactorArray<2*MAX_BND> ninety_factors = admissible_rotadrome_factors(P, 90);
+  FactorArray<2*MAX_BND> ninety_factors = admissible_rotadrome_factors(bank, 90);
   if (has_quarter_turn_tiling(P, ninety_factors, palin_factors)) {
     return true;
   }
 
-  FactorArray<MAX_BND*MAX_BND> reflect_square_factors = admissible_reflect_square_factors(P);
+  FactorArray<MAX_BND*MAX_BND> reflect_square_factors = admissible_reflect_square_factors(bank);
   if (has_type_1_reflection_tiling(P, reflect_square_factors, mirror_factor_pairs)) {
     return true;
   }
-  if (has_type_2_reflection_tiling(P, mirror_factors)) {
+  if (has_type_2_reflection_tiling(bank, mirror_factors)) {
     return true;
   }
 
   if (has_type_1_half_turn_reflection_tiling(P, mirror_factor_pairs, palin_factors, reflect_square_factors)) {
     return true;
   }
-  if (has_type_2_half_turn_reflection_tiling(P, palin_factors)) {
+  if (has_type_2_half_turn_reflection_tiling(bank, palin_factors)) {
     return true;
   }
 
-  FactorArray<2*MAX_BND> onetwenty_factors = admissible_rotadrome_factors(P, 120);
+  FactorArray<2*MAX_BND> onetwenty_factors = admissible_rotadrome_factors(bank, 120);
   if (has_case_7_tiling(P, onetwenty_factors)) {
     return true;
   }
 
-  FactorArray<2*MAX_BND> sixty_factors = admissible_rotadrome_factors(P, 60);
+  FactorArray<2*MAX_BND> sixty_factors = admissible_rotadrome_factors(bank, 60);
   if (has_case_8a_tiling(P, palin_factors, sixty_factors, onetwenty_factors)) {
     return true;
   }
@@ -737,3 +820,225 @@ bool IsohedralChecker::has_isohedral_tiling(const boundaryword &P) {
   return false;
 }
 
+
+IsohedralChecker IsohedralChecker::forGrid(GridType grid) {
+  if (grid == HEX) {
+    pair<int, int> U = {-1, 2};
+    pair<int, int> D = {1, -2};
+    pair<int, int> R = {1, 1};
+    pair<int, int> r = {2, -1};
+    pair<int, int> L = {-2, 1};
+    pair<int, int> l = {-1, -1};
+    LetterMap complement = {
+      {U, D},
+      {D, U},
+      {l, R},
+      {R, l},
+      {L, r},
+      {r, L}
+    };
+    LetterMap cw = {
+      {U, R},
+      {R, r},
+      {r, D},
+      {D, l},
+      {l, L},
+      {L, U}
+    };
+    LetterMap ccw = {
+      {R, U},
+      {U, L},
+      {L, l},
+      {l, D},
+      {D, r},
+      {r, R}
+    };
+    map<int, LetterMap> refl = {
+      {-60, {
+        {D, r}, {r, D}, {l, R}, {R, l}, {L, U}, {U, L}
+      }},
+      {-30, {
+
+        {r, r}, {D, R}, {R, D}, {l, U}, {U, l}, {L, L}
+      }},
+      {0, {
+        {r, R}, {R, r}, {U, D}, {D, U}, {L, l}, {l, L}
+      }},
+      {30, {
+        {R, R}, {r, U}, {U, r}, {L, D}, {D, L}, {l, l}
+      }},
+      {60, {
+        {U, R}, {R, U}, {L, r}, {r, L}, {D, l}, {l, D}
+      }},
+      {90, {
+        {U, U}, {L, R}, {R, L}, {l, r}, {r, l}, {D, D}
+      }},
+    };
+    return IsohedralChecker(60, complement, ccw, cw, refl);
+  } else if (grid == IAMOND) {
+    pair<int, int> E = {3, 0};
+    pair<int, int> NE = {0, 3};
+    pair<int, int> NW = {-3, 3};
+    pair<int, int> W = {-3, 0};
+    pair<int, int> SW = {0, -3};
+    pair<int, int> SE = {3, -3};
+    LetterMap complement = {
+      {E, W},
+      {W, E},
+      {NE, SW},
+      {SW, NE},
+      {NW, SE},
+      {SE, NW}
+    };
+    LetterMap ccw = {
+      {E, NE},
+      {NE, NW},
+      {NW, W},
+      {W, SW},
+      {SW, SE},
+      {SE, E}
+    };
+    LetterMap cw = {
+      {E, SE},
+      {SE, SW},
+      {SW, W},
+      {W, NW},
+      {NW, NE},
+      {NE, E}
+    };
+    map<int, LetterMap> refl = {
+      {-60, {
+        {SE, SE}, {E, SW}, {SW, E}, {NE, W}, {W, NE}, {NW, NW}
+      }},
+      {-30, {
+        {E, SE}, {SE, E}, {NE, SW}, {SW, NE}, {W, NW}, {NW, W}
+      }},
+      {0, {
+        {E, E}, {NE, SE}, {SE, NE}, {SW, NW}, {NW, SW}, {W, W}
+      }},
+      {30, {
+        {E, NE}, {NE, E}, {NW, SE}, {SE, NW}, {W, SW}, {SW, W}
+      }},
+      {60, {
+        {NE, NE}, {E, NW}, {NW, E}, {W, SE}, {SE, W}, {SW, SW}
+      }},
+      {90, {
+        {NE, NW}, {NW, NE}, {E, W}, {W, E}, {SW, SE}, {SE, SW}
+      }},
+    };
+    return IsohedralChecker(60, complement, ccw, cw, refl);
+  } else if (grid == KITE) {
+    pair<int, int> U = {-1, 2};
+    pair<int, int> D = {1, -2};
+    pair<int, int> NE = {1, 1};
+    pair<int, int> SW = {-1, -1};
+    pair<int, int> NW = {-2, 1};
+    pair<int, int> SE = {2, -1};
+    
+    pair<int, int> e = {1, 0};
+    pair<int, int> w = {-1, 0};
+    pair<int, int> ne = {0, 1};
+    pair<int, int> sw = {0, -1};
+    pair<int, int> nw = {-1, 1};
+    pair<int, int> se = {1, -1};
+
+    LetterMap complement = {
+      {U, D},
+      {D, U},
+      {NE, SW},
+      {SW, NE},
+      {NW, SE},
+      {SE, NW},
+      {e, w},
+      {w, e},
+      {ne, sw},
+      {sw, ne},
+      {nw, se},
+      {se, nw}
+    };
+    LetterMap cw = {
+      {NE, SE},
+      {SE, D},
+      {D, SW},
+      {SW, NW},
+      {NW, U},
+      {U, NE},
+      {e, se},
+      {se, sw},
+      {sw, w},
+      {w, nw},
+      {nw, ne},
+      {ne, e}
+    };
+    LetterMap ccw = {
+      {NE, U},
+      {U, NW},
+      {NW, SW},
+      {SW, D},
+      {D, SE},
+      {SE, NE},
+      {e, ne},
+      {ne, nw},
+      {nw, w},
+      {w, sw},
+      {sw, se},
+      {se, e}
+    };
+    map<int, LetterMap> refl = {
+      {-60, {
+        {se, se}, {e, sw}, {sw, e}, {ne, w}, {w, ne}, {nw, nw},
+        {D, SE}, {SE, D}, {SW, NE}, {NE, SW}, {U, NW}, {NW, U}
+      }},
+      {-30, {
+        {SE, SE}, {D, NE}, {NE, D}, {SW, U}, {U, SW}, {NW, NW},
+        {e, se}, {se, e}, {sw, ne}, {ne, sw}, {nw, w}, {w, nw}
+      }},
+      {0, {
+        {e, e}, {se, ne}, {ne, se}, {nw, sw}, {sw, nw}, {w, w},
+        {NE, SE}, {SE, NE}, {U, D}, {D, U}, {SW, NW}, {NW, SW}
+      }},
+      {30, {
+        {NE, NE}, {U, SE}, {SE, U}, {D, NW}, {NW, D}, {SW, SW},
+        {e, ne}, {ne, e}, {nw, se}, {se, nw}, {w, sw}, {sw, w}
+      }},
+      {60, {
+        {ne, ne}, {e, nw}, {nw, e}, {w, se}, {se, w}, {sw, sw},
+        {U, NE}, {NE, U}, {NW, SE}, {SE, NW}, {D, SW}, {SW, D}
+      }},
+      {90, {
+        {U, U}, {NW, NE}, {NE, NW}, {SE, SW}, {SW, SE}, {D, D},
+        {ne, nw}, {nw, ne}, {e, w}, {w, e}, {se, sw}, {sw, se}
+      }},
+    };
+    return IsohedralChecker(60, complement, ccw, cw, refl);
+  }
+  pair<int, int> U = {0, 1};
+  pair<int, int> D = {0, -1};
+  pair<int, int> R = {1, 0};
+  pair<int, int> L = {-1, 0};
+  LetterMap complement = {
+    {U, D},
+    {D, U},
+    {R, L},
+    {L, R}
+  };
+  LetterMap ccw = {
+    {U, L},
+    {R, U},
+    {D, R},
+    {L, D}
+  };
+  LetterMap cw = {
+    {L, U},
+    {U, R},
+    {R, D},
+    {D, L}
+  };
+  map<int, LetterMap> refl = {
+    {-45, {{U, L}, {R, D}, {D, R}, {L, U}}},
+    {0, {{U, D}, {R, R}, {D, U}, {L, L}}},
+    {45, {{U, R}, {R, U}, {D, L}, {L, D}}},
+    {90, {{U, U}, {R, L}, {D, D}, {L, R}}},
+  };
+  return IsohedralChecker(90, complement, ccw, cw, refl);
+}
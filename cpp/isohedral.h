@@ -2,21 +2,32 @@
 #define ISOHEDRAL_H
 
 #include "boundary.h"
+#include "boundary_corpus.h"
 
 #include <algorithm>
 #include <array>
 #include <cassert>
 #include <cmath>
-#include <iostream>
+#include <cstdint>
 #include <map>
 #include <set>
 #include <string>
-#include <map>
 #include <utility>
 #include <vector>
 
 constexpr int MAX_BND = 50;
 
+// Whether a boundary word of n letters can be checked. The factor arrays
+// of the checker are sized for MAX_BND letters, so longer words must be
+// rejected before they reach has_isohedral_tiling or check_batch.
+inline bool fits_checker(size_t n) {
+  return n <= size_t(MAX_BND);
+}
+
+// Bump whenever a change to the checker can alter its results, so that
+// persisted results from older versions are recomputed.
+constexpr uint16_t CHECKER_VERSION = 1;
+
 using Factor = std::pair<int, int>;
 
 // A wrapper around stl array that provides range based iteration
@@ -39,6 +50,16 @@ struct PartialArray {
   }
 };
 
+// Copies values into array and marks them filled. The factors of a word
+// that fits_checker always fit, so more than N values is a caller error.
+template <typename T, size_t N>
+void fill_partial(PartialArray<T, N>& array, const std::vector<T>& values) {
+  assert(values.size() <= N && "factor list longer than its array");
+  size_t count = std::min(values.size(), N);
+  std::copy(values.begin(), values.begin() + count, array.data.begin());
+  array.filled_count = count;
+}
+
 template <size_t N>
 using FactorArray = PartialArray<Factor, N>;
 
@@ -53,87 +74,185 @@ using FactorPairArray = PartialArray<FactorPair, N>;
 // in the boundary word.
 bool is_double_palindrome(const Factor& F, const std::vector<std::vector<Factor>>& palindrome_factor_starts, const std::vector<std::vector<Factor>>& palindrome_factor_ends, int n);
 
+// The edge tables of a grid frozen into flat arrays indexed by packed
+// letter (see pack_letter). Lookups are const and read a few hundred
+// bytes, so one checker can be shared by every thread without locking.
+// Letters without an image map to 0, the packing of {0, 0}, which is no
+// edge.
+struct LetterTables {
+  // The letters of the grid in sorted order.
+  std::vector<std::pair<int, int>> letters;
+  std::array<uint8_t, 256> complement{};
+  std::array<uint8_t, 256> ccw{};
+  std::array<uint8_t, 256> cw{};
+  // Reflections by increasing angle.
+  std::vector<std::pair<int, std::array<uint8_t, 256>>> refl;
+
+  LetterTables() = default;
+  LetterTables(const LetterMap& complement_map, const LetterMap& ccw_map, const LetterMap& cw_map,
+               const std::map<int, LetterMap>& refl_map);
+
+  // Packs a letter of the grid. Every grid's letters fit, so a letter
+  // that doesn't is a caller error rather than something to map to 0.
+  static uint8_t pack(const std::pair<int, int>& c) {
+    uint8_t byte = 0;
+    bool packed = pack_letter(c, byte);
+    assert(packed && "letter outside the packable range");
+    (void)packed;
+    return byte;
+  }
+
+  static std::pair<int, int> apply(const std::array<uint8_t, 256>& table, const std::pair<int, int>& c) {
+    return unpack_letter(table[pack(c)]);
+  }
+};
+
+// A non-owning view of a word of packed letters (see pack_letter) read
+// cyclically from a start position, forwards (step 1) or backwards
+// (step -1), with every letter optionally passed through a letter table.
+// Letter k is table[word[(start + step * k) mod n]], so rotated, reversed
+// and transformed words are read without building them, e.g. inv_comp(P)
+// is CyclicView(P, n, n - 1, -1, &tables.complement).
+struct CyclicView {
+  const uint8_t* word;
+  int n;
+  int start;
+  int step;
+  const std::array<uint8_t, 256>* table;
+
+  CyclicView(const uint8_t* word, int n, int start, int step = 1,
+             const std::array<uint8_t, 256>* table = nullptr)
+      : word(word), n(n), start(n == 0 ? 0 : ((start % n) + n) % n), step(step), table(table) {}
+
+  uint8_t operator[](int k) const {
+    uint8_t c = word[(((start + step * k) % n) + n) % n];
+    return table ? (*table)[c] : c;
+  }
+};
+
+// Every transformed copy of a word that the admissible factor routines
+// compare, built once per word by writing out a CyclicView of it.
+// Letters are packed into bytes (see pack_letter), and each copy is
+// stored twice over so that a cyclic read of up to n letters from any
+// position is one contiguous run.
+struct TransformBank {
+  int n = 0;
+  std::vector<uint8_t> forward;
+  std::vector<uint8_t> reverse;
+  // inv_comp(P).
+  std::vector<uint8_t> reverse_complement;
+  // rotated[k] has every letter turned counterclockwise k times.
+  std::vector<std::vector<uint8_t>> rotated;
+  // The reflections of P, by angle.
+  std::map<int, std::vector<uint8_t>> reflected;
+
+  int mod(int i) const {
+    return ((i % n) + n) % n;
+  }
+
+  // Letters start, start + 1, ... of the word a copy was made from.
+  const uint8_t* from(const std::vector<uint8_t>& copy, int start) const {
+    return copy.data() + mod(start);
+  }
+
+  // Letters start, start - 1, ... of the word a reversed copy was made
+  // from.
+  const uint8_t* back_from(const std::vector<uint8_t>& reversed_copy, int start) const {
+    return reversed_copy.data() + (n - 1 - mod(start));
+  }
+};
+
 // A struct which checks whether a boundary word corresponds to 
 // a shape that tiles the plane isohedrally.
 //
-// The default fields of the struct are for the polyomino grid.
-// Assumes equal angle between edges in the grid.
+// A default constructed checker is for the polyomino grid.
+// Assumes equal angle between edges in the grid. The grid's edge maps
+// are given to the constructor and frozen into tables there; they can't
+// be changed afterwards, and every checking method is const, so a
+// checker may be shared across threads.
 struct IsohedralChecker {
 
-// The angle between edges of the grid.
-int minAngle = 90;
-
-// The complement of edges in the grid.
-std::map<std::pair<int, int>, std::pair<int, int>> COMPLEMENT = {
-  {{0, 1}, {0, -1}},
-  {{0, -1}, {0, 1}},
-  {{1, 0}, {-1, 0}},
-  {{-1, 0}, {1, 0}}
-};
+// Returns a checker with the edge tables of the given grid.
+static IsohedralChecker forGrid(GridType grid);
 
-// The result of rotating an edge counterclockwise.
-std::map<std::pair<int, int>, std::pair<int, int>> CCW = {
-  {{0, 1}, {-1, 0}},
-  {{1, 0}, {0, 1}},
-  {{0, -1}, {1, 0}},
-  {{-1, 0}, {0, -1}}
-};
+// A checker for the polyomino grid.
+IsohedralChecker();
 
-std::map<std::pair<int, int>, std::pair<int, int>> CW = {
-    {{-1, 0}, {0, 1}},
-    {{0, 1}, {1, 0}},
-    {{1, 0}, {0, -1}},
-    {{0, -1}, {-1, 0}}
-};
+// A checker for a grid whose edges are min_angle degrees apart, with the
+// complement, counterclockwise and clockwise turn of each edge, and its
+// reflections keyed by the angle of the mirror.
+IsohedralChecker(int min_angle, const LetterMap& complement, const LetterMap& ccw, const LetterMap& cw,
+                 const std::map<int, LetterMap>& refl);
 
-// The results of reflecting edges in the grid.
-std::map<int, std::map<std::pair<int, int>, std::pair<int, int>>> REFL = {
-  {-45, {{{0, 1}, {-1, 0}}, {{1, 0}, {0, -1}}, {{0, -1}, {1, 0}}, {{-1, 0}, {0, 1}}}},
-  {0, {{{0, 1}, {0, -1}}, {{1, 0}, {1, 0}}, {{0, -1}, {0, 1}}, {{-1, 0}, {-1, 0}}}},
-  {45, {{{0, 1}, {1, 0}}, {{1, 0}, {0, 1}}, {{0, -1}, {-1, 0}}, {{-1, 0}, {0, -1}}}},
-  {90, {{{0, 1}, {0, 1}}, {{1, 0}, {-1, 0}}, {{0, -1}, {0, -1}}, {{-1, 0}, {1, 0}}}},
-};
+// The frozen edge tables.
+const LetterTables& letter_tables() const { return tables; }
 
 // Rotates dir counterclockwise numIters times.
-std::pair<int, int> iteratedCcw(std::pair<int, int> dir, int numIters);
+std::pair<int, int> iteratedCcw(std::pair<int, int> dir, int numIters) const;
+
+// Builds the transformed copies of P the admissible factor routines read.
+TransformBank transform_bank(const boundaryword& P) const;
 
 // Returns if P[i, j] is of the form A refl(A).
-bool is_reflect_square_factor(const boundaryword& P, int i, int j, int theta);
+bool is_reflect_square_factor(const TransformBank& bank, int i, int j, int theta) const;
 
 // Reverses S and takes the componentwise complement.
-boundaryword inv_comp(const boundaryword& S);
+boundaryword inv_comp(const boundaryword& S) const;
+
+// Returns a representative shared by every boundary word of the same free
+// polyform: the least rotation over all images of P under the grid's
+// rotations and reflections. Reflected images are reversed and
+// complemented so they stay clockwise.
+boundaryword canonical_form(const boundaryword& P) const;
+
+FactorArray<2*MAX_BND> admissible_mirror_factors(const TransformBank& bank) const;
 
-FactorArray<2*MAX_BND> admissible_mirror_factors(const boundaryword& P);
+FactorPairArray<MAX_BND*MAX_BND> admissible_gapped_mirror_factor_pairs(const TransformBank& bank) const;
 
-FactorPairArray<MAX_BND*MAX_BND> admissible_gapped_mirror_factor_pairs(const boundaryword& P);
+FactorArray<2*MAX_BND> admissible_rotadrome_factors(const TransformBank& bank, int theta) const;
 
-FactorArray<2*MAX_BND> admissible_rotadrome_factors(const boundaryword& P, int theta);
+FactorArray<MAX_BND*MAX_BND> admissible_reflect_square_factors(const TransformBank& bank) const;
 
-FactorArray<MAX_BND*MAX_BND> admissible_reflect_square_factors(const boundaryword& P);
+std::vector<std::pair<Factor, Factor>> admissible_gapped_reflect_square_factor_pairs(const TransformBank& bank, int theta) const;
 
-std::vector<std::pair<Factor, Factor>> admissible_gapped_reflect_square_factor_pairs(const boundaryword& P, int theta);
+bool has_translation_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& mirror_factors) const;
 
-bool has_translation_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& mirror_factors);
+bool has_half_turn_tiling(const boundaryword& P, const FactorPairArray<MAX_BND*MAX_BND>& mirror_factor_pairs, const FactorArray<2*MAX_BND>& palin_factors) const;
 
-bool has_half_turn_tiling(const boundaryword& P, const FactorPairArray<MAX_BND*MAX_BND>& mirror_factor_pairs, const FactorArray<2*MAX_BND>& palin_factors);
+bool has_quarter_turn_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& ninety_factors, const FactorArray<2*MAX_BND>& palin_factors) const;
 
-bool has_quarter_turn_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& ninety_factors, const FactorArray<2*MAX_BND>& palin_factors);
+bool has_type_1_reflection_tiling(const boundaryword& P, const FactorArray<MAX_BND*MAX_BND>& reflect_square_factors, const FactorPairArray<MAX_BND*MAX_BND>& mirror_factor_pairs) const;
 
-bool has_type_1_reflection_tiling(const boundaryword& P, const FactorArray<MAX_BND*MAX_BND>& reflect_square_factors, const FactorPairArray<MAX_BND*MAX_BND>& mirror_factor_pairs);
+bool has_type_2_reflection_tiling(const TransformBank& bank, const FactorArray<2*MAX_BND>& mirror_factors) const;
 
-bool has_type_2_reflection_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& mirror_factors);
+bool has_type_1_half_turn_reflection_tiling(const boundaryword& P, const FactorPairArray<MAX_BND*MAX_BND>& partial_mirror_factor_pairs, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<MAX_BND*MAX_BND>& reflect_square_factors) const;
 
-bool has_type_1_half_turn_reflection_tiling(const boundaryword& P, const FactorPairArray<MAX_BND*MAX_BND>& partial_mirror_factor_pairs, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<MAX_BND*MAX_BND>& reflect_square_factors);
+bool has_type_2_half_turn_reflection_tiling(const TransformBank& bank, const FactorArray<2*MAX_BND>& palin_factors) const;
 
-bool has_type_2_half_turn_reflection_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors);
+bool has_case_7_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& onetwenty_factors) const;
 
-bool has_case_7_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& onetwenty_factors);
+bool has_case_8a_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<2*MAX_BND>& sixty_factors, const FactorArray<2*MAX_BND>& onetwenty_factors) const;
 
-bool has_case_8a_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<2*MAX_BND>& sixty_factors, const FactorArray<2*MAX_BND>& onetwenty_factors);
+bool has_case_8b_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<2*MAX_BND>& sixty_factors, const FactorArray<2*MAX_BND>& onetwenty_factors) const;
 
-bool has_case_8b_tiling(const boundaryword& P, const FactorArray<2*MAX_BND>& palin_factors, const FactorArray<2*MAX_BND>& sixty_factors, const FactorArray<2*MAX_BND>& onetwenty_factors);
+// P must fit the checker (see fits_checker).
+bool has_isohedral_tiling(const boundaryword& P) const;
+
+// Returns has_isohedral_tiling for every word. Words of equal length are
+// laid out together letter-major (structure of arrays), and the
+// admissible factor kernels step through one letter position of the
+// whole group at a time, so comparisons vectorize across words. Words
+// decided by a tiling type drop out before the next factors are computed.
+// Every word must fit the checker; one that doesn't is reported as not
+// isohedral without being checked.
+std::vector<bool> check_batch(const BoundaryCorpus& words) const;
+std::vector<bool> check_batch(const std::vector<boundaryword>& words) const;
+
+private:
+// The angle between edges of the grid.
+int minAngle;
 
-bool has_isohedral_tiling(const boundaryword& P);
+LetterTables tables;
 
 };
 
@@ -0,0 +1,463 @@
+#include "boundary.h"
+#include "isohedral.h"
+#include "letter_kernels.h"
+#include "phase_timer.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace {
+
+// Words checked together in lockstep. One letter position of every lane
+// is a row of LANES bytes, so a comparison step covers the whole group.
+constexpr int LANES = 64;
+
+// Letter codes of a grid: the index of each letter in the sorted
+// alphabet, with the edge tables as lookup arrays on codes.
+struct LetterCodes {
+  vector<pair<int, int>> letters;
+  array<uint8_t, 256> complement;
+  array<uint8_t, 256> ccw;
+  vector<array<uint8_t, 256>> refl;
+
+  uint8_t code(const pair<int, int>& letter) const {
+    auto it = lower_bound(letters.begin(), letters.end(), letter);
+    if (it == letters.end() || *it != letter) {
+      return NO_LETTER;
+    }
+    return uint8_t(it - letters.begin());
+  }
+};
+
+// Lanes of equal length n laid out letter-major: row k holds letter k of
+// every lane, so P[k * width + w] is letter k of lane w.
+struct LaneBlock {
+  int n = 0;
+  int width = 0;
+  vector<uint8_t> P;
+  const LetterKernels* kernels = nullptr;
+  // Whether every letter code fits the 16 entry tables of the kernels.
+  bool small_alphabet = false;
+
+  // Applies a code table to every letter.
+  vector<uint8_t> transformed(const array<uint8_t, 256>& table) const {
+    vector<uint8_t> result(P.size());
+    if (small_alphabet) {
+      kernels->translate(P.data(), result.data(), P.size(), table.data());
+      return result;
+    }
+    for (size_t i = 0; i < P.size(); ++i) {
+      result[i] = table[P[i]];
+    }
+    return result;
+  }
+
+  const uint8_t* row(const vector<uint8_t>& S, int k) const {
+    return S.data() + size_t(k) * width;
+  }
+};
+
+// Computes for every lane the length, capped at ub, of the longest common
+// prefix of the cyclic sequences A[a_start + a_step*k] and
+// B[b_start + b_step*k], where steps are +1 or -1 and indices are taken
+// mod n. Stops as soon as every lane has mismatched.
+void lockstep_match(const LaneBlock& block, const vector<uint8_t>& A, int a_start, int a_step,
+                    const vector<uint8_t>& B, int b_start, int b_step, int ub, uint8_t* len) {
+  int n = block.n;
+  int width = block.width;
+  uint8_t alive[LANES];
+  fill(alive, alive + width, 1);
+  fill(len, len + width, 0);
+  int a = ((a_start % n) + n) % n;
+  int b = ((b_start % n) + n) % n;
+  for (int k = 0; k < ub; ++k) {
+    const uint8_t* ra = block.row(A, a);
+    const uint8_t* rb = block.row(B, b);
+    if (!block.kernels->match_step(ra, rb, alive, len, width)) {
+      break;
+    }
+    a += a_step;
+    a = (a == n) ? 0 : (a < 0 ? n - 1 : a);
+    b += b_step;
+    b = (b == n) ? 0 : (b < 0 ? n - 1 : b);
+  }
+}
+
+// Per-lane factor lists produced by the lockstep kernels.
+struct LaneFactors {
+  vector<FactorPair> mirror_factor_pairs;
+  vector<Factor> palin_factors;
+  vector<Factor> mirror_factors;
+  vector<Factor> ninety_factors;
+  vector<Factor> reflect_square_factors;
+  vector<Factor> onetwenty_factors;
+  vector<Factor> sixty_factors;
+};
+
+// Lockstep version of admissible_mirror_factors.
+void batch_mirror_factors(const LaneBlock& block, const vector<uint8_t>& comp,
+                          vector<LaneFactors>& lanes) {
+  ScopedPhase timer(PHASE_MIRROR_FACTORS);
+  int n = block.n;
+  uint8_t l[LANES], r[LANES];
+  for (int i = 0; i < n; ++i) {
+    int h = (i + n / 2) % n;
+    lockstep_match(block, comp, i - 1, -1, block.P, h, 1, n / 4, l);
+    lockstep_match(block, block.P, i, 1, comp, h - 1, -1, n / 4, r);
+    for (int w = 0; w < block.width; ++w) {
+      if (l[w] == r[w] && r[w] > 0) {
+        lanes[w].mirror_factors.push_back({(i - l[w] + n) % n, (i - 1 + r[w] + n) % n});
+      }
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    int h = (i + n / 2) % n;
+    const uint8_t* pi = block.row(block.P, i);
+    const uint8_t* ch = block.row(comp, h);
+    lockstep_match(block, comp, i - 1, -1, block.P, h + 1, 1, (n - 2) / 4, l);
+    lockstep_match(block, block.P, i + 1, 1, comp, h - 1, -1, (n - 2) / 4, r);
+    for (int w = 0; w < block.width; ++w) {
+      if (pi[w] == ch[w] && l[w] == r[w]) {
+        lanes[w].mirror_factors.push_back({(i - l[w] + n) % n, (i + r[w]) % n});
+      }
+    }
+  }
+}
+
+// Lockstep version of admissible_gapped_mirror_factor_pairs.
+void batch_gapped_mirror_factor_pairs(const LaneBlock& block, const vector<uint8_t>& comp,
+                                      vector<LaneFactors>& lanes) {
+  ScopedPhase timer(PHASE_GAPPED_MIRROR_FACTORS);
+  int n = block.n;
+  uint8_t l[LANES], r[LANES];
+  for (int i = 0; i < n; ++i) {
+    for (int j = i + 1; j < n; ++j) {
+      lockstep_match(block, comp, i - 1, -1, block.P, j, 1, (i + n - j) / 2, l);
+      lockstep_match(block, block.P, i, 1, comp, j - 1, -1, (j - i) / 2, r);
+      for (int w = 0; w < block.width; ++w) {
+        if (l[w] == r[w] && r[w] > 0) {
+          lanes[w].mirror_factor_pairs.push_back({{(i - l[w] + n) % n, (i - 1 + r[w] + n) % n},
+                                                  {(j - l[w] + n) % n, (j - 1 + r[w] + n) % n}});
+        }
+      }
+    }
+  }
+  for (int i = 0; i < n; ++i) {
+    const uint8_t* pi = block.row(block.P, i);
+    for (int j = i + 1; j < n; ++j) {
+      const uint8_t* cj = block.row(comp, j);
+      lockstep_match(block, comp, i - 1, -1, block.P, j + 1, 1, (i + n - j - 1) / 2, l);
+      lockstep_match(block, block.P, i + 1, 1, comp, j - 1, -1, (j - i - 1) / 2, r);
+      for (int w = 0; w < block.width; ++w) {
+        if (pi[w] == cj[w] && l[w] == r[w]) {
+          lanes[w].mirror_factor_pairs.push_back({{(i - l[w] + n) % n, (i + r[w]) % n},
+                                                  {(j - l[w] + n) % n, (j + r[w]) % n}});
+        }
+      }
+    }
+  }
+}
+
+// Lockstep version of admissible_rotadrome_factors. rotated holds every
+// letter turned by 180 - theta degrees, or is empty if the grid has no
+// such rotation.
+void batch_rotadrome_factors(const LaneBlock& block, const vector<uint8_t>& rotated, int theta,
+                             vector<Factor> LaneFactors::*out, vector<LaneFactors>& lanes) {
+  ScopedPhase timer(PHASE_ROTADROME_FACTORS);
+  int n = block.n;
+  uint8_t l[LANES];
+  if (!rotated.empty()) {
+    for (int i = 0; i < n; ++i) {
+      lockstep_match(block, block.P, i - 1, -1, rotated, i, 1, n / 2, l);
+      for (int w = 0; w < block.width; ++w) {
+        if (l[w] > 0) {
+          (lanes[w].*out).push_back({(i - l[w] + n) % n, (i - 1 + l[w]) % n});
+        }
+      }
+    }
+  }
+  // Palindrome factors centred in the middle of a letter.
+  if (theta == 180) {
+    for (int i = 0; i < n; ++i) {
+      lockstep_match(block, block.P, i - 1, -1, block.P, i + 1, 1, n / 2, l);
+      for (int w = 0; w < block.width; ++w) {
+        (lanes[w].*out).push_back({(i - l[w] + n) % n, (i + l[w]) % n});
+      }
+    }
+  }
+}
+
+// Lockstep version of admissible_reflect_square_factors.
+void batch_reflect_square_factors(const LaneBlock& block, const vector<vector<uint8_t>>& reflected,
+                                  vector<LaneFactors>& lanes) {
+  ScopedPhase timer(PHASE_REFLECT_SQUARE_FACTORS);
+  int n = block.n;
+  uint8_t m[LANES];
+  for (int i = 0; i < n; ++i) {
+    for (int j = 0; j < n; ++j) {
+      if (j == i) {
+        continue;
+      }
+      int l = j - i + 1 + n * (j < i);
+      if (l % 2 != 0) {
+        continue;
+      }
+      l /= 2;
+      for (const vector<uint8_t>& R: reflected) {
+        lockstep_match(block, block.P, i, 1, R, i + l, 1, l + 1, m);
+        for (int w = 0; w < block.width; ++w) {
+          if (m[w] == l) {
+            lanes[w].reflect_square_factors.push_back({i, j});
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+vector<bool> IsohedralChecker::check_batch(const vector<boundaryword>& words) const {
+  vector<bool> results(words.size(), false);
+  BoundaryCorpus corpus;
+  vector<size_t> ids;
+  for (size_t i = 0; i < words.size(); ++i) {
+    if (corpus.push_back(words[i])) {
+      ids.push_back(i);
+    } else if (fits_checker(words[i].size())) {
+      results[i] = has_isohedral_tiling(words[i]);
+    } else {
+      assert(!"word too long for the checker");
+    }
+  }
+  vector<bool> packed = check_batch(corpus);
+  for (size_t k = 0; k < ids.size(); ++k) {
+    results[ids[k]] = packed[k];
+  }
+  return results;
+}
+
+vector<bool> IsohedralChecker::check_batch(const BoundaryCorpus& words) const {
+  vector<bool> results(words.size(), false);
+  const LetterKernels& kernels = letter_kernels();
+
+  LetterCodes codes;
+  codes.letters = tables.letters;
+  codes.complement.fill(NO_LETTER);
+  codes.ccw.fill(NO_LETTER);
+  for (size_t c = 0; c < codes.letters.size(); ++c) {
+    codes.complement[c] = codes.code(LetterTables::apply(tables.complement, codes.letters[c]));
+    codes.ccw[c] = codes.code(LetterTables::apply(tables.ccw, codes.letters[c]));
+  }
+  for (auto& p: tables.refl) {
+    array<uint8_t, 256> table;
+    table.fill(NO_LETTER);
+    for (size_t c = 0; c < codes.letters.size(); ++c) {
+      table[c] = codes.code(LetterTables::apply(p.second, codes.letters[c]));
+    }
+    codes.refl.push_back(table);
+  }
+  // Letter codes of packed corpus letters.
+  array<uint8_t, 256> byte_code;
+  byte_code.fill(NO_LETTER);
+  for (size_t c = 0; c < codes.letters.size(); ++c) {
+    uint8_t byte;
+    if (pack_letter(codes.letters[c], byte)) {
+      byte_code[byte] = uint8_t(c);
+    }
+  }
+  // Code table turning a letter by angle degrees, or an empty one if the
+  // grid has no such rotation.
+  auto rotation = [&](int angle, array<uint8_t, 256>& table) {
+    if (angle % minAngle != 0) {
+      return false;
+    }
+    for (int c = 0; c < 256; ++c) {
+      uint8_t r = uint8_t(c);
+      for (int k = 0; k < angle / minAngle && r != NO_LETTER; ++k) {
+        r = codes.ccw[r];
+      }
+      table[c] = r;
+    }
+    return true;
+  };
+
+  // Group words of equal length, then cut each group into lane blocks.
+  map<size_t, vector<size_t>> by_length;
+  for (size_t i = 0; i < words.size(); ++i) {
+    by_length[words[i].size].push_back(i);
+  }
+
+  // The word being decided, unpacked.
+  boundaryword unpacked;
+  FactorPairArray<MAX_BND*MAX_BND> mirror_factor_pairs;
+  FactorArray<2*MAX_BND> palin_factors;
+  FactorArray<2*MAX_BND> mirror_factors;
+  FactorArray<2*MAX_BND> ninety_factors;
+  FactorArray<MAX_BND*MAX_BND> reflect_square_factors;
+  FactorArray<2*MAX_BND> onetwenty_factors;
+  FactorArray<2*MAX_BND> sixty_factors;
+
+  for (auto& group: by_length) {
+    int n = group.first;
+    const vector<size_t>& members = group.second;
+    if (n == 0) {
+      for (size_t idx: members) {
+        results[idx] = has_isohedral_tiling(words.word(idx));
+      }
+      continue;
+    }
+    if (!fits_checker(n)) {
+      assert(!"word too long for the checker");
+      continue;
+    }
+
+    for (size_t first = 0; first < members.size(); first += LANES) {
+      vector<size_t> ids(members.begin() + first,
+                         members.begin() + min(members.size(), first + LANES));
+      vector<LaneFactors> factors(ids.size());
+      // Positions in ids of the words still undecided.
+      vector<int> pending(ids.size());
+      for (size_t w = 0; w < ids.size(); ++w) {
+        pending[w] = w;
+      }
+
+      // Lays out the pending words as a lane block and runs a kernel on
+      // it, then hands each lane's factors back to its word.
+      auto run_stage = [&](auto kernel) {
+        LaneBlock block;
+        block.n = n;
+        block.width = pending.size();
+        block.P.resize(size_t(n) * block.width);
+        block.kernels = &kernels;
+        block.small_alphabet = codes.letters.size() <= 16;
+        for (int w = 0; w < block.width; ++w) {
+          WordSpan word = words[ids[pending[w]]];
+          for (int k = 0; k < n; ++k) {
+            block.P[size_t(k) * block.width + w] = byte_code[word[k]];
+          }
+        }
+        vector<LaneFactors> lanes(block.width);
+        kernel(block, lanes);
+        for (int w = 0; w < block.width; ++w) {
+          LaneFactors& dst = factors[pending[w]];
+          LaneFactors& src = lanes[w];
+          auto move_if = [](auto& to, auto& from) {
+            if (!from.empty()) {
+              to = std::move(from);
+            }
+          };
+          move_if(dst.mirror_factor_pairs, src.mirror_factor_pairs);
+          move_if(dst.palin_factors, src.palin_factors);
+          move_if(dst.mirror_factors, src.mirror_factors);
+          move_if(dst.ninety_factors, src.ninety_factors);
+          move_if(dst.reflect_square_factors, src.reflect_square_factors);
+          move_if(dst.onetwenty_factors, src.onetwenty_factors);
+          move_if(dst.sixty_factors, src.sixty_factors);
+        }
+      };
+      // Runs a per-word test on every pending word and drops those that
+      // tile.
+      auto decide = [&](auto test) {
+        vector<int> still;
+        for (int w: pending) {
+          size_t idx = ids[w];
+          words.decode(idx, unpacked);
+          if (test(unpacked, factors[w])) {
+            results[idx] = true;
+          } else {
+            still.push_back(w);
+          }
+        }
+        pending.swap(still);
+        return !pending.empty();
+      };
+
+      run_stage([&](const LaneBlock& block, vector<LaneFactors>& lanes) {
+        vector<uint8_t> comp = block.transformed(codes.complement);
+        batch_gapped_mirror_factor_pairs(block, comp, lanes);
+        array<uint8_t, 256> rot;
+        bool has_rot = rotation(0, rot);
+        batch_rotadrome_factors(block, has_rot ? block.transformed(rot) : vector<uint8_t>(),
+                                180, &LaneFactors::palin_factors, lanes);
+      });
+      if (!decide([&](const boundaryword& P, const LaneFactors& f) {
+            fill_partial(mirror_factor_pairs, f.mirror_factor_pairs);
+            fill_partial(palin_factors, f.palin_factors);
+            return has_half_turn_tiling(P, mirror_factor_pairs, palin_factors);
+          })) {
+        continue;
+      }
+
+      run_stage([&](const LaneBlock& block, vector<LaneFactors>& lanes) {
+        batch_mirror_factors(block, block.transformed(codes.complement), lanes);
+      });
+      if (!decide([&](const boundaryword& P, const LaneFactors& f) {
+            fill_partial(mirror_factors, f.mirror_factors);
+            return has_translation_tiling(P, mirror_factors);
+          })) {
+        continue;
+      }
+
+      run_stage([&](const LaneBlock& block, vector<LaneFactors>& lanes) {
+        array<uint8_t, 256> rot;
+        bool has_rot = rotation(90, rot);
+        batch_rotadrome_factors(block, has_rot ? block.transformed(rot) : vector<uint8_t>(),
+                                90, &LaneFactors::ninety_factors, lanes);
+      });
+      if (!decide([&](const boundaryword& P, const LaneFactors& f) {
+            fill_partial(ninety_factors, f.ninety_factors);
+            fill_partial(palin_factors, f.palin_factors);
+            return has_quarter_turn_tiling(P, ninety_factors, palin_factors);
+          })) {
+        continue;
+      }
+
+      run_stage([&](const LaneBlock& block, vector<LaneFactors>& lanes) {
+        vector<vector<uint8_t>> reflected;
+        for (auto& table: codes.refl) {
+          reflected.push_back(block.transformed(table));
+        }
+        batch_reflect_square_factors(block, reflected, lanes);
+      });
+      if (!decide([&](const boundaryword& P, const LaneFactors& f) {
+            fill_partial(mirror_factor_pairs, f.mirror_factor_pairs);
+            fill_partial(palin_factors, f.palin_factors);
+            fill_partial(mirror_factors, f.mirror_factors);
+            fill_partial(reflect_square_factors, f.reflect_square_factors);
+            TransformBank bank = transform_bank(P);
+            return has_type_1_reflection_tiling(P, reflect_square_factors, mirror_factor_pairs)
+                || has_type_2_reflection_tiling(bank, mirror_factors)
+                || has_type_1_half_turn_reflection_tiling(P, mirror_factor_pairs, palin_factors, reflect_square_factors)
+                || has_type_2_half_turn_reflection_tiling(bank, palin_factors);
+          })) {
+        continue;
+      }
+
+      run_stage([&](const LaneBlock& block, vector<LaneFactors>& lanes) {
+        array<uint8_t, 256> rot;
+        bool has_rot = rotation(60, rot);
+        batch_rotadrome_factors(block, has_rot ? block.transformed(rot) : vector<uint8_t>(),
+                                120, &LaneFactors::onetwenty_factors, lanes);
+        has_rot = rotation(120, rot);
+        batch_rotadrome_factors(block, has_rot ? block.transformed(rot) : vector<uint8_t>(),
+                                60, &LaneFactors::sixty_factors, lanes);
+      });
+      decide([&](const boundaryword& P, const LaneFactors& f) {
+        fill_partial(palin_factors, f.palin_factors);
+        fill_partial(onetwenty_factors, f.onetwenty_factors);
+        fill_partial(sixty_factors, f.sixty_factors);
+        return has_case_7_tiling(P, onetwenty_factors)
+            || has_case_8a_tiling(P, palin_factors, sixty_factors, onetwenty_factors)
+            || has_case_8b_tiling(P, palin_factors, sixty_factors, onetwenty_factors);
+      });
+    }
+  }
+  return results;
+}
@@ -1,316 +1,1273 @@
 #include "boundary.h"
+#include "checkpoint.h"
+#include "compressed_input.h"
+#include "enumerate.h"
+#include "input.h"
 #include "isohedral.h"
+#include "letter_kernels.h"
+#include "phase_timer.h"
+#include "progress.h"
 #include "ominogrid.h"
+#include "ordered_writer.h"
+#include "partial_result.h"
+#include "result_cache.h"
+#include "result_memo.h"
+#include "word_file.h"
+#include "work_queue.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cassert>
 #include <chrono>
 #include <cmath>
 #include <ctime>
 #include <cstdlib>
-#include <fstream>
 #include <future>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <numeric>
-#include <sstream>
 #include <string>
+#include <string_view>
 #include <thread>
 
 using namespace std;
 
-int main(int argc, char **argv) {
-  cout << "argc: " << argc << "\n";
-  if (argc != 3) {
-    cout << "Usage: ./isohedral_e2e [grid type. choices are: omino, hex, kite, iamond]";
-    return -1;
+// Number of boundary words handed to a checker thread at a time.
+constexpr size_t CHUNK_SIZE = 1024;
+
+// Target size of the line-aligned batches a mapped input is cut into,
+// and the minimum number of batches per thread for small inputs.
+constexpr size_t BATCH_BYTES = 16 << 10;
+constexpr size_t BATCHES_PER_THREAD = 16;
+
+// Bytes a streamed input is read in at a time.
+constexpr size_t STREAM_BLOCK = 256 << 10;
+
+// Minimum number of enumeration subtrees per thread. Subtrees differ
+// widely in size, so there are many more of them than threads. Sharded
+// enumerations split into a number of subtrees per shard instead, so
+// that every node splits the tree the same way whatever its thread count.
+constexpr size_t SUBTREES_PER_THREAD = 64;
+constexpr size_t SUBTREES_PER_SHARD = 1024;
+
+// Command-line settings shared by every grid's pipeline.
+struct Options {
+  std::string fileName;
+  std::string gridName;
+  // Enumerate free polyforms up to this size instead of reading a file.
+  int enumerateSize = 0;
+  bool dedup = false;
+  std::string cachePath;
+  // Number of checker threads; 0 means one per hardware thread.
+  size_t numThreads = 0;
+  // Per-phase timing report: empty for none, "table" or "json".
+  std::string timing;
+  // This run handles shard shardIndex of shardCount, and writes its
+  // counts to partialPath if that is set.
+  size_t shardIndex = 0;
+  size_t shardCount = 1;
+  std::string partialPath;
+  // Write the run's progress to checkpointPath every checkpointInterval
+  // seconds, and with resume, pick up from the progress saved there.
+  std::string checkpointPath;
+  double checkpointInterval = 60;
+  bool resume = false;
+  // Per-shape output of a file input: each polyform's line number and
+  // result to resultsPath, and the lines of the polyforms that aren't
+  // isohedral to filterPath.
+  std::string resultsPath;
+  std::string filterPath;
+  // Print progress every progressInterval seconds; 0 for none.
+  double progressInterval = 0;
+};
+
+// The result of each line written to the results file. Lines whose
+// boundary isn't simple, such as polyforms with holes, can't tile and are
+// reported as not isohedral. Lines that couldn't be parsed or traced are
+// reported as unchecked. A word waiting for the checker is pending.
+enum ShapeOutcome : int8_t {
+  SHAPE_UNCHECKED = -1,
+  SHAPE_NOT_ISOHEDRAL = 0,
+  SHAPE_ISOHEDRAL = 1,
+  SHAPE_PENDING = 2,
+};
+
+// Per-run state shared by all checker threads.
+struct CheckContext {
+  const Options& options;
+  const IsohedralChecker checker;
+
+  // Results keyed by canonical form, so repeated free polyforms are
+  // checked only once.
+  ResultMemo<bool> memo;
+  ResultCache cache;
+  std::atomic<size_t> cache_hits{0};
+
+  // One set of phase counters per thread, when timing.
+  std::vector<PhaseTimes> phase_times;
+
+  // The progress the run starts from, which is a loaded checkpoint when
+  // resumed is set, and the writer that records finished work when
+  // checkpointing.
+  CheckpointState start;
+  bool resumed = false;
+  std::unique_ptr<CheckpointWriter> checkpoint;
+
+  // Live progress counters, when reporting progress.
+  std::unique_ptr<ProgressReporter> progress;
+
+  // Per-shape output, in input order.
+  OrderedWriter results;
+  OrderedWriter filtered;
+
+  CheckContext(const Options& options, GridType grid)
+      : options(options), checker(IsohedralChecker::forGrid(grid)) {}
+
+  // Records that the work is divided into num_tasks tasks with the given
+  // target. A resumed checkpoint that divided it differently can't be
+  // used, and the run starts over.
+  void begin_tasks(size_t num_tasks, size_t target) {
+    if (resumed && start.num_tasks == num_tasks && start.target == target) {
+      return;
+    }
+    if (resumed) {
+      std::cerr << "Checkpoint doesn't match this run's tasks, starting from the beginning\n";
+      start.totals.counts = Tally();
+      start.totals.sizes.clear();
+      resumed = false;
+    }
+    start.num_tasks = num_tasks;
+    start.target = target;
+    start.done.assign(num_tasks, false);
   }
-  
-  std::string fileName = argv[1];
-
-  std::string gridType = argv[2];
-
-  IsohedralChecker checker;
-  if (gridType == "hex") {
-    pair<int, int> U = {-1, 2};
-    pair<int, int> D = {1, -2};
-    pair<int, int> R = {1, 1};
-    pair<int, int> r = {2, -1};
-    pair<int, int> L = {-2, 1};
-    pair<int, int> l = {-1, -1};
-    checker.minAngle = 60;
-    checker.COMPLEMENT = {
-      {U, D},
-      {D, U},
-      {l, R},
-      {R, l},
-      {L, r},
-      {r, L}
-    };
-    checker.CW = {
-      {U, R},
-      {R, r},
-      {r, D},
-      {D, l},
-      {l, L},
-      {L, U}
-    };
-    checker.CCW = {
-      {R, U},
-      {U, L},
-      {L, l},
-      {l, D},
-      {D, r},
-      {r, R}
-    };
-    checker.REFL = {
-      {-60, {
-        {D, r}, {r, D}, {l, R}, {R, l}, {L, U}, {U, L}
-      }},
-      {-30, {
-
-        {r, r}, {D, R}, {R, D}, {l, U}, {U, l}, {L, L}
-      }},
-      {0, {
-        {r, R}, {R, r}, {U, D}, {D, U}, {L, l}, {l, L}
-      }},
-      {30, {
-        {R, R}, {r, U}, {U, r}, {L, D}, {D, L}, {l, l}
-      }},
-      {60, {
-        {U, R}, {R, U}, {L, r}, {r, L}, {D, l}, {l, D}
-      }},
-      {90, {
-        {U, U}, {L, R}, {R, L}, {l, r}, {r, l}, {D, D}
-      }},
-    };
-  } else if (gridType == "iamond") {
-    pair<int, int> E = {3, 0};
-    pair<int, int> NE = {0, 3};
-    pair<int, int> NW = {-3, 3};
-    pair<int, int> W = {-3, 0};
-    pair<int, int> SW = {0, -3};
-    pair<int, int> SE = {3, -3};
-    checker.minAngle = 60;
-
-    checker.COMPLEMENT = {
-      {E, W},
-      {W, E},
-      {NE, SW},
-      {SW, NE},
-      {NW, SE},
-      {SE, NW}
-    };
-    checker.CCW = {
-      {E, NE},
-      {NE, NW},
-      {NW, W},
-      {W, SW},
-      {SW, SE},
-      {SE, E}
-    };
-    checker.CW = {
-      {E, SE},
-      {SE, SW},
-      {SW, W},
-      {W, NW},
-      {NW, NE},
-      {NE, E}
-    };
-    checker.REFL = {
-      {-60, {
-        {SE, SE}, {E, SW}, {SW, E}, {NE, W}, {W, NE}, {NW, NW}
-      }},
-      {-30, {
-        {E, SE}, {SE, E}, {NE, SW}, {SW, NE}, {W, NW}, {NW, W}
-      }},
-      {0, {
-        {E, E}, {NE, SE}, {SE, NE}, {SW, NW}, {NW, SW}, {W, W}
-      }},
-      {30, {
-        {E, NE}, {NE, E}, {NW, SE}, {SE, NW}, {W, SW}, {SW, W}
-      }},
-      {60, {
-        {NE, NE}, {E, NW}, {NW, E}, {W, SE}, {SE, W}, {SW, SW}
-      }},
-      {90, {
-        {NE, NW}, {NW, NE}, {E, W}, {W, E}, {SW, SE}, {SE, SW}
-      }},
-    };
-  } else if (gridType == "kite") {
-    pair<int, int> U = {-1, 2};
-    pair<int, int> D = {1, -2};
-    pair<int, int> NE = {1, 1};
-    pair<int, int> SW = {-1, -1};
-    pair<int, int> NW = {-2, 1};
-    pair<int, int> SE = {2, -1};
-    
-    pair<int, int> e = {1, 0};
-    pair<int, int> w = {-1, 0};
-    pair<int, int> ne = {0, 1};
-    pair<int, int> sw = {0, -1};
-    pair<int, int> nw = {-1, 1};
-    pair<int, int> se = {1, -1};
-
-    checker.minAngle = 60;
-    checker.COMPLEMENT = {
-      {U, D},
-      {D, U},
-      {NE, SW},
-      {SW, NE},
-      {NW, SE},
-      {SE, NW},
-      {e, w},
-      {w, e},
-      {ne, sw},
-      {sw, ne},
-      {nw, se},
-      {se, nw}
-    };
-    checker.CW = {
-      {NE, SE},
-      {SE, D},
-      {D, SW},
-      {SW, NW},
-      {NW, U},
-      {U, NE},
-      {e, se},
-      {se, sw},
-      {sw, w},
-      {w, nw},
-      {nw, ne},
-      {ne, e}
-    };
-    checker.CCW = {
-      {NE, U},
-      {U, NW},
-      {NW, SW},
-      {SW, D},
-      {D, SE},
-      {SE, NE},
-      {e, ne},
-      {ne, nw},
-      {nw, w},
-      {w, sw},
-      {sw, se},
-      {se, e}
-    };
-    checker.REFL = {
-      {-60, {
-        {se, se}, {e, sw}, {sw, e}, {ne, w}, {w, ne}, {nw, nw},
-        {D, SE}, {SE, D}, {SW, NE}, {NE, SW}, {U, NW}, {NW, U}
-      }},
-      {-30, {
-        {SE, SE}, {D, NE}, {NE, D}, {SW, U}, {U, SW}, {NW, NW},
-        {e, se}, {se, e}, {sw, ne}, {ne, sw}, {nw, w}, {w, nw}
-      }},
-      {0, {
-        {e, e}, {se, ne}, {ne, se}, {nw, sw}, {sw, nw}, {w, w},
-        {NE, SE}, {SE, NE}, {U, D}, {D, U}, {SW, NW}, {NW, SW}
-      }},
-      {30, {
-        {NE, NE}, {U, SE}, {SE, U}, {D, NW}, {NW, D}, {SW, SW},
-        {e, ne}, {ne, e}, {nw, se}, {se, nw}, {w, sw}, {sw, w}
-      }},
-      {60, {
-        {ne, ne}, {e, nw}, {nw, e}, {w, se}, {se, w}, {sw, sw},
-        {U, NE}, {NE, U}, {NW, SE}, {SE, NW}, {D, SW}, {SW, D}
-      }},
-      {90, {
-        {U, U}, {NW, NE}, {NE, NW}, {SE, SW}, {SW, SE}, {D, D},
-        {ne, nw}, {nw, ne}, {e, w}, {w, e}, {se, sw}, {sw, se}
-      }},
-    };
+
+  bool shape_output() const {
+    return !options.resultsPath.empty() || !options.filterPath.empty();
   }
 
+  // Hands the per-shape output of block seq of the input to the writers,
+  // given the line number (counting from 1), text and outcome of each
+  // line in the block. The pending outcomes are filled from checked, the
+  // results of the block's words in order. lines may be empty when not
+  // filtering. The filter keeps every line that isn't known to tile.
+  void write_shapes(size_t seq, const std::vector<size_t>& line_numbers,
+                    const std::vector<std::string_view>& lines, std::vector<int8_t>& outcomes,
+                    const std::vector<bool>& checked) {
+    size_t next = 0;
+    for (int8_t& outcome: outcomes) {
+      if (outcome == SHAPE_PENDING) {
+        outcome = checked[next++] ? SHAPE_ISOHEDRAL : SHAPE_NOT_ISOHEDRAL;
+      }
+    }
+    assert(next == checked.size());
+    if (!options.resultsPath.empty()) {
+      std::string text;
+      for (size_t i = 0; i < line_numbers.size(); ++i) {
+        text += std::to_string(line_numbers[i]);
+        text += ' ';
+        text += std::to_string(outcomes[i]);
+        text += '\n';
+      }
+      results.submit(seq, std::move(text));
+    }
+    if (!options.filterPath.empty()) {
+      std::string text;
+      for (size_t i = 0; i < lines.size(); ++i) {
+        if (outcomes[i] != SHAPE_ISOHEDRAL) {
+          text += lines[i];
+          text += '\n';
+        }
+      }
+      filtered.submit(seq, std::move(text));
+    }
+  }
 
+  // Adds finished work of the thread with the given slot to the progress
+  // counters.
+  void count_progress(size_t slot, size_t words, size_t isohedral, size_t units) {
+    if (progress) {
+      progress->add(slot, words, isohedral, units);
+    }
+  }
 
-  // Parse polyominoes from file
-  std::cout << "Computing isohedral tilers for " << fileName << "\n";
-  std::ifstream inputFile(fileName);
+  // Starts writing checkpoints from the start state, if enabled.
+  void start_checkpoint() {
+    if (!options.checkpointPath.empty()) {
+      checkpoint.reset(new CheckpointWriter(options.checkpointPath, options.checkpointInterval, start));
+    }
+  }
 
-  if (!inputFile.is_open()) {
-    std::cerr << "Error opening file: " << fileName << "\n";
-    return -1;
+  // Points the calling thread's phase counters at the given slot.
+  void time_thread(size_t slot) {
+    thread_phase_times = phase_times.empty() ? nullptr : &phase_times[slot];
   }
 
-  int num_isohedral = 0;
-  std::string line;
-  std::vector<boundaryword> boundary_words;
-  while (std::getline(inputFile, line)) {
-    std::istringstream iss(line);
-    std::string temp;
-    iss >> temp; // Skip the 0? part
-    
-    std::vector<int> nums;
-    int num;
-    while (iss >> num) {
-      nums.push_back(num);
-    }
-
-    if (nums.size() % 2 != 0) {
-      std::cerr << "Error: Odd number of integers in line.\n";
+  // Checks a group of words with check_batch. Words whose canonical form
+  // is already in the memo or the cache are answered from there instead.
+  std::vector<bool> check_all(const BoundaryCorpus& words) {
+    if (!options.dedup && !cache.is_open()) {
+      return checker.check_batch(words);
+    }
+    std::vector<bool> results(words.size());
+    // The words to check, and for each the index of the word it came
+    // from and its cache key.
+    BoundaryCorpus misses;
+    struct Miss {
+      size_t id;
+      uint64_t key;
+    };
+    std::vector<Miss> miss_info;
+    boundaryword word;
+    for (size_t i = 0; i < words.size(); ++i) {
+      words.decode(i, word);
+      boundaryword canonical = checker.canonical_form(word);
+      bool isohedral;
+      if (options.dedup && memo.find(canonical, isohedral)) {
+        results[i] = isohedral;
+        continue;
+      }
+      uint64_t key = 0;
+      if (cache.is_open()) {
+        key = boundary_fingerprint(canonical);
+        uint32_t cached;
+        if (cache.find(key, ResultCache::ISOHEDRAL, cached)) {
+          cache_hits.fetch_add(1, std::memory_order_relaxed);
+          results[i] = cached;
+          if (options.dedup) {
+            memo.insert(canonical, cached);
+          }
+          continue;
+        }
+      }
+      // The canonical form is made of the grid's letters, which all pack.
+      bool packed = misses.push_back(canonical);
+      assert(packed);
+      (void)packed;
+      miss_info.push_back({i, key});
+    }
+
+    std::vector<bool> checked = checker.check_batch(misses);
+    assert(checked.size() == miss_info.size());
+    for (size_t m = 0; m < miss_info.size(); ++m) {
+      results[miss_info[m].id] = checked[m];
+      if (cache.is_open()) {
+        cache.insert(miss_info[m].key, ResultCache::ISOHEDRAL, checked[m]);
+      }
+      if (options.dedup) {
+        memo.insert(misses.word(m), checked[m]);
+      }
+    }
+    return results;
+  }
+};
+
+// Adds the boundary word of a parsed line to words and returns
+// SHAPE_PENDING, or returns the line's outcome when it has no word to
+// check: a polyform whose boundary isn't simple can't tile, and a line
+// that couldn't be parsed or traced, or whose boundary is too long to
+// check, is left unchecked. Each is added to tally.
+template <typename grid>
+int8_t trace_line(const Shape<grid>& shape, ParseStatus status, BoundaryCorpus& words, Tally& tally) {
+  if (const char* error = parse_error(status)) {
+    std::cerr << "Error: " << error << "\n";
+    ++tally.num_unchecked;
+    return SHAPE_UNCHECKED;
+  }
+  ScopedPhase timer(PHASE_BOUNDARY);
+  if (!hasSimpleBoundary(shape)) {
+    ++tally.num_polyforms;
+    ++tally.num_not_simple;
+    return SHAPE_NOT_ISOHEDRAL;
+  }
+  boundaryword word = getBoundaryWord(shape);
+  if (!fits_checker(word.size())) {
+    std::cerr << "Error: Boundary of " << word.size() << " letters is longer than " << MAX_BND << ".\n";
+    ++tally.num_polyforms;
+    ++tally.num_unchecked;
+    return SHAPE_UNCHECKED;
+  }
+  if (!words.push_back(word)) {
+    std::cerr << "Error: Boundary letter out of range.\n";
+    ++tally.num_unchecked;
+    return SHAPE_UNCHECKED;
+  }
+  ++tally.num_polyforms;
+  return SHAPE_PENDING;
+}
+
+// Parses and traces every line in [begin, end), then checks the words
+// together. With per-shape output, the results are written as block
+// batch, whose first line has number first_line counting from 0.
+template <typename grid>
+Tally check_lines(const char* begin, const char* end, CheckContext& context,
+                  size_t batch = 0, size_t first_line = 0) {
+  Tally tally;
+  Shape<grid> shape;
+  BoundaryCorpus words;
+  bool output = context.shape_output();
+  std::vector<size_t> line_numbers;
+  std::vector<std::string_view> lines;
+  std::vector<int8_t> outcomes;
+  for (size_t line_number = first_line; begin < end; ++line_number) {
+    const char* p = begin;
+    const char* eol = find_line_end(p, end);
+    ParseStatus status;
+    {
+      ScopedPhase timer(PHASE_PARSE);
+      status = parse_shape_line(p, eol, shape);
+    }
+    begin = eol + 1;
+    if (status == PARSE_EMPTY) {
       continue;
     }
+    int8_t outcome = trace_line(shape, status, words, tally);
+    if (output) {
+      line_numbers.push_back(line_number + 1);
+      lines.emplace_back(p, eol - p);
+      outcomes.push_back(outcome);
+    }
+  }
 
-    Shape<OminoGrid<int>> shape = Shape<OminoGrid<int>>();
-    for (int i = 0; i < nums.size(); i += 2) {
-      shape.add(nums[i], nums[i+1]);
+  std::vector<bool> results = context.check_all(words);
+  for (bool isohedral: results) {
+    tally.num_isohedral += isohedral;
+  }
+  if (output) {
+    context.write_shapes(batch, line_numbers, lines, outcomes, results);
+  }
+  return tally;
+}
+
+// Splits a mapped input into small line-aligned batches that a
+// work-stealing pool hands out, so threads that draw cheap words keep
+// taking work from slower ones until the end of the run. Each worker
+// parses, traces and checks a batch end to end, and the per-batch tallies
+// are merged in input order.
+//
+// A shard covers one of shardCount line-aligned byte ranges of equal
+// size, so a node only ever pages in and parses its own part of the file.
+template <typename grid>
+Tally run_mapped(const MappedFile& input, CheckContext& context, size_t num_threads) {
+  const Options& options = context.options;
+  std::vector<const char*> shards = split_at_lines(input.begin(), input.end(), options.shardCount);
+  const char* begin = shards[options.shardIndex];
+  const char* end = shards[options.shardIndex + 1];
+
+  // A resumed run cuts the input into the same batches as the checkpoint.
+  size_t num_batches = context.resumed
+      ? context.start.target
+      : std::max<size_t>((end - begin) / BATCH_BYTES, BATCHES_PER_THREAD * num_threads);
+  std::vector<const char*> bounds = split_at_lines(begin, end, num_batches);
+  context.begin_tasks(num_batches, num_batches);
+  std::vector<size_t> pending;
+  for (size_t batch = 0; batch < num_batches; ++batch) {
+    if (!context.start.done[batch]) {
+      pending.push_back(batch);
     }
+  }
+  context.start_checkpoint();
+  if (context.progress) {
+    size_t pending_bytes = 0;
+    for (size_t batch: pending) {
+      pending_bytes += bounds[batch + 1] - bounds[batch];
+    }
+    context.progress->set_total_units(pending_bytes);
+  }
 
-    boundaryword boundary = getBoundaryWord(shape);
-    boundary_words.push_back(boundary);
+  // Per-shape output needs the number of the first line of each batch.
+  std::vector<size_t> first_lines(num_batches);
+  if (context.shape_output()) {
+    size_t line = std::count(input.begin(), begin, '\n');
+    for (size_t batch = 0; batch < num_batches; ++batch) {
+      first_lines[batch] = line;
+      line += std::count(bounds[batch], bounds[batch + 1], '\n');
+    }
   }
 
-  cout << "Done extracting boundary words\n";
-  cout << "Num polyominoes: " << boundary_words.size() << "\n";
+  std::vector<Tally> tallies(num_batches);
+  WorkStealingPool pool(num_threads);
+  pool.run(pending.size(), [&](size_t task, size_t worker) {
+    context.time_thread(worker);
+    size_t batch = pending[task];
+    tallies[batch] = check_lines<grid>(bounds[batch], bounds[batch + 1], context, batch, first_lines[batch]);
+    context.count_progress(worker, tallies[batch].num_polyforms, tallies[batch].num_isohedral,
+                           bounds[batch + 1] - bounds[batch]);
+    if (context.checkpoint) {
+      context.checkpoint->complete_task(batch, tallies[batch], {});
+    }
+  });
 
-  auto start = std::chrono::high_resolution_clock::now();
+  Tally total = context.start.totals.counts;
+  for (const Tally& tally: tallies) {
+    total += tally;
+  }
+  return total;
+}
 
-  size_t num_threads = std::thread::hardware_concurrency();
-  size_t chunk_size = boundary_words.size() / num_threads;
-  if (chunk_size == 0) {
-    chunk_size = boundary_words.size();
-    num_threads = 1;
+// Checks a word file written by the convert subcommand. Its blocks are
+// loaded straight from the mapping, with no parsing or tracing, and
+// handed out by a work-stealing pool. A shard covers one of shardCount
+// ranges of consecutive blocks.
+Tally run_word_file(const std::vector<const char*>& blocks, const WordFileHeader& header,
+                    CheckContext& context, size_t num_threads) {
+  const Options& options = context.options;
+  size_t first = blocks.size() * options.shardIndex / options.shardCount;
+  size_t num_blocks = blocks.size() * (options.shardIndex + 1) / options.shardCount - first;
+  context.begin_tasks(num_blocks, num_blocks);
+  // Shard 0 counts the polyforms that convert left out, as a run on the
+  // text input would have.
+  if (!context.resumed && options.shardIndex == 0) {
+    context.start.totals.counts.num_polyforms += header.num_polyforms - header.num_words;
+    context.start.totals.counts.num_not_simple += header.num_not_simple;
+    context.start.totals.counts.num_unchecked += header.num_unchecked;
   }
+  std::vector<size_t> pending;
+  for (size_t block = 0; block < num_blocks; ++block) {
+    if (!context.start.done[block]) {
+      pending.push_back(block);
+    }
+  }
+  context.start_checkpoint();
+  if (context.progress) {
+    context.progress->set_total_units(pending.size());
+  }
+
+  std::vector<Tally> tallies(num_blocks);
+  WorkStealingPool pool(num_threads);
+  pool.run(pending.size(), [&](size_t task, size_t worker) {
+    context.time_thread(worker);
+    size_t block = pending[task];
+    BoundaryCorpus words;
+    {
+      ScopedPhase timer(PHASE_READ);
+      read_word_block(blocks[first + block], words);
+    }
+    Tally& tally = tallies[block];
+    tally.num_polyforms = words.size();
+    for (bool isohedral: context.check_all(words)) {
+      tally.num_isohedral += isohedral;
+    }
+    context.count_progress(worker, tally.num_polyforms, tally.num_isohedral, 1);
+    if (context.checkpoint) {
+      context.checkpoint->complete_task(block, tally, {});
+    }
+  });
+
+  Tally total = context.start.totals.counts;
+  for (const Tally& tally: tallies) {
+    total += tally;
+  }
+  return total;
+}
+
+// For inputs that can't be mapped, such as pipes. The calling thread
+// parses the input and extracts boundary words in chunks, which checker
+// threads take from a bounded queue. Memory use is independent of the
+// input size, and parsing overlaps with checking. A shard takes the
+// lines whose number is shardIndex modulo shardCount.
+//
+// Chunks are numbered in input order and remember the line they end
+// before, so a checkpoint can record how far the input is done.
+struct StreamChunk {
+  size_t index = 0;
+  size_t end_line = 0;
+  BoundaryCorpus words;
+  // The chunk's counts. Polyforms whose boundary isn't simple aren't
+  // among the words.
+  Tally counts;
+  // For per-shape output, the line number and outcome of each line and,
+  // when filtering, its text followed by a newline.
+  std::vector<size_t> line_numbers;
+  std::vector<int8_t> outcomes;
+  std::string text;
+};
+
+template <typename grid>
+Tally run_streamed(std::istream& input, CheckContext& context, size_t num_threads) {
+  BoundedQueue<StreamChunk> queue(4 * num_threads);
+  context.start_checkpoint();
 
-  std::vector<std::future<int>> futures;
+  std::vector<std::future<Tally>> futures;
   for (size_t i = 0; i < num_threads; ++i) {
-    size_t start = i * chunk_size;
-    size_t end = (i == num_threads - 1) ? boundary_words.size() : (i + 1) * chunk_size;
-
-    futures.push_back(std::async(std::launch::async, [start, end, &boundary_words, &checker]() {
-      int local_count = 0;
-      for (size_t j = start; j < end; ++j) {
-        if (checker.has_isohedral_tiling(boundary_words[j])) {
-          ++local_count;
+    futures.push_back(std::async(std::launch::async, [&queue, &context, i]() {
+      context.time_thread(i);
+      Tally local;
+      StreamChunk chunk;
+      while (queue.pop(chunk)) {
+        std::vector<bool> results = context.check_all(chunk.words);
+        for (bool isohedral: results) {
+          chunk.counts.num_isohedral += isohedral;
         }
+        if (context.shape_output()) {
+          std::vector<std::string_view> lines;
+          for (size_t p = 0; p < chunk.text.size();) {
+            size_t eol = chunk.text.find('\n', p);
+            lines.emplace_back(chunk.text.data() + p, eol - p);
+            p = eol + 1;
+          }
+          context.write_shapes(chunk.index, chunk.line_numbers, lines, chunk.outcomes, results);
+        }
+        context.count_progress(i, chunk.counts.num_polyforms, chunk.counts.num_isohedral, 0);
+        if (context.checkpoint) {
+          context.checkpoint->complete_chunk(chunk.index, chunk.end_line, chunk.counts);
+        }
+        local += chunk.counts;
       }
-      return local_count;
+      return local;
     }));
   }
 
-  // Collect the  results from each future
-  std::vector<int> results;
+  // The reading thread has the slot after the checkers.
+  context.time_thread(num_threads);
+  Shape<grid> shape;
+  StreamChunk chunk;
+  size_t line_number = 0;
+  auto add_line = [&](const char* line, const char* eol) {
+    size_t number = line_number++;
+    // Lines before lines_done were checked before the run was resumed.
+    if (number < context.start.lines_done ||
+        number % context.options.shardCount != context.options.shardIndex) {
+      return;
+    }
+    ParseStatus status;
+    {
+      ScopedPhase timer(PHASE_PARSE);
+      status = parse_shape_line(line, eol, shape);
+    }
+    if (status == PARSE_EMPTY) {
+      return;
+    }
+    int8_t outcome = trace_line(shape, status, chunk.words, chunk.counts);
+    if (context.shape_output()) {
+      chunk.line_numbers.push_back(number + 1);
+      chunk.outcomes.push_back(outcome);
+    }
+    if (!context.options.filterPath.empty()) {
+      chunk.text.append(line, eol);
+      chunk.text += '\n';
+    }
+    if (chunk.counts.num_polyforms == CHUNK_SIZE) {
+      chunk.end_line = number + 1;
+      size_t next_index = chunk.index + 1;
+      queue.push(std::move(chunk));
+      chunk.words.clear();
+      chunk.counts = Tally();
+      chunk.line_numbers.clear();
+      chunk.outcomes.clear();
+      chunk.text.clear();
+      chunk.index = next_index;
+    }
+  };
+
+  // The input is read a block at a time. block holds the unfinished last
+  // line of the previous block followed by the new bytes.
+  std::string block;
+  bool at_end = false;
+  while (!at_end) {
+    size_t kept = block.size();
+    block.resize(kept + STREAM_BLOCK);
+    {
+      ScopedPhase timer(PHASE_READ);
+      input.read(&block[kept], STREAM_BLOCK);
+      block.resize(kept + input.gcount());
+    }
+    at_end = !input;
+    const char* p = block.data();
+    const char* end = p + block.size();
+    while (p < end) {
+      const char* eol = find_line_end(p, end);
+      if (eol == end && !at_end) {
+        break;
+      }
+      add_line(p, eol);
+      p = eol + (eol < end);
+    }
+    block.erase(0, p - block.data());
+  }
+  if (chunk.counts.num_polyforms > 0 || chunk.counts.num_unchecked > 0) {
+    chunk.end_line = line_number;
+    queue.push(std::move(chunk));
+  }
+  queue.close();
+
+  Tally total = context.start.totals.counts;
   for (auto& future: futures) {
-    results.push_back(future.get());
+    total += future.get();
   }
+  return total;
+}
 
-  num_isohedral = std::accumulate(results.begin(), results.end(), 0);
+// The per-thread state of an enumeration run. The boundary of each free
+// polyform the search finds is spliced from its parent's and added to a
+// corpus, which is checked a chunk at a time.
+template <typename grid>
+struct EnumerationSink {
+  const PolyformEnumerator<grid>& enumerator;
+  CheckContext& context;
+  // The progress slot of the thread that owns the sink.
+  size_t slot;
+  std::vector<SizeTally> tallies;
+  BoundaryCorpus words;
+  // Size and number of fixed copies of each word in the corpus.
+  std::vector<std::pair<size_t, size_t>> info;
+  Shape<grid> shape;
+  Shape<grid> image;
+  TracedBoundary<grid> boundary;
 
-  cout << "Num isohedral: " << num_isohedral << "\n\n";
+  EnumerationSink(const PolyformEnumerator<grid>& enumerator, CheckContext& context, size_t slot)
+      : enumerator(enumerator), context(context), slot(slot), tallies(enumerator.maxSize() + 1) {}
+
+  void operator()(const std::vector<typename grid::point_t>& cells,
+                  const TracedBoundary<grid>& parent) {
+    size_t num_fixed;
+    {
+      ScopedPhase timer(PHASE_CANONICAL);
+      if (!enumerator.isFreeCanonical(cells, num_fixed, shape, image)) {
+        return;
+      }
+    }
+    SizeTally& tally = tallies[cells.size()];
+    ++tally.num_free;
+    bool packed;
+    {
+      ScopedPhase timer(PHASE_BOUNDARY);
+      enumerator.childBoundary(parent, cells, boundary, shape);
+      if (!boundary.simple) {
+        ++tally.num_holey;
+        return;
+      }
+      if (!fits_checker(boundary.word.size())) {
+        ++tally.num_too_long;
+        return;
+      }
+      packed = words.push_back(boundary.word);
+    }
+    if (!packed) {
+      std::cerr << "Error: Boundary letter out of range.\n";
+      return;
+    }
+    info.emplace_back(cells.size(), num_fixed);
+    if (words.size() == CHUNK_SIZE) {
+      flush();
+    }
+  }
+
+  void flush() {
+    std::vector<bool> results = context.check_all(words);
+    size_t num_isohedral = 0;
+    for (size_t i = 0; i < results.size(); ++i) {
+      if (results[i]) {
+        ++num_isohedral;
+        ++tallies[info[i].first].num_isohedral;
+        tallies[info[i].first].num_fixed_isohedral += info[i].second;
+      }
+    }
+    context.count_progress(slot, results.size(), num_isohedral, 0);
+    words.clear();
+    info.clear();
+  }
+
+  // Checks the words still in the corpus and returns the counts so far,
+  // which start over from zero.
+  std::vector<SizeTally> take() {
+    flush();
+    std::vector<SizeTally> counts(tallies.size());
+    counts.swap(tallies);
+    return counts;
+  }
+};
+
+// Adds up the counts of an enumeration, whose polyforms with holes are
+// the ones that aren't simple and whose too long polyforms are the
+// unchecked ones.
+Tally size_counts(const std::vector<SizeTally>& sizes) {
+  Tally counts;
+  for (size_t size = 1; size < sizes.size(); ++size) {
+    counts.num_polyforms += sizes[size].num_free;
+    counts.num_isohedral += sizes[size].num_isohedral;
+    counts.num_not_simple += sizes[size].num_holey;
+    counts.num_unchecked += sizes[size].num_too_long;
+  }
+  return counts;
+}
+
+// Enumerates the free polyforms of the grid up to the given size and
+// checks each one as it is found, with no intermediate file. The calling
+// thread splits the search tree into subtrees, which a work-stealing pool
+// searches in parallel. Fills sizes with the counts per size.
+//
+// A shard searches the subtrees whose index is shardIndex modulo
+// shardCount; the polyforms found while splitting belong to shard 0.
+//
+// When checkpointing, each subtree is a task whose counts are reported
+// once its last words are checked, and a resumed run only searches the
+// subtrees that weren't done.
+template <typename grid>
+Tally run_enumerated(CheckContext& context, size_t num_threads, std::vector<SizeTally>& sizes) {
+  const Options& options = context.options;
+  int max_size = options.enumerateSize;
+  PolyformEnumerator<grid> enumerator(max_size);
+  std::vector<EnumerationSink<grid>> sinks;
+  for (size_t i = 0; i <= num_threads; ++i) {
+    sinks.emplace_back(enumerator, context, i);
+  }
+
+  // The splitting thread has the slot after the workers. A resumed run
+  // splits into the same subtrees as the checkpoint, and its counts
+  // already include those of the split.
+  size_t min_subtrees = context.resumed
+      ? context.start.target
+      : options.shardCount > 1
+      ? SUBTREES_PER_SHARD * options.shardCount
+      : SUBTREES_PER_THREAD * num_threads;
+  auto skip = [](const std::vector<typename grid::point_t>&, const TracedBoundary<grid>&) {};
+  EnumerationSink<grid>& split_sink = sinks[num_threads];
+  std::vector<EnumerationNode<grid>> subtrees = options.shardIndex == 0 && !context.resumed
+      ? enumerator.split(min_subtrees, split_sink)
+      : enumerator.split(min_subtrees, skip);
+  bool was_resumed = context.resumed;
+  context.begin_tasks(subtrees.size(), min_subtrees);
+  if (was_resumed && !context.resumed && options.shardIndex == 0) {
+    subtrees = enumerator.split(min_subtrees, split_sink);
+  }
+
+  // Puts the counts of the split in the start state, so that every
+  // checkpoint includes them.
+  sizes = split_sink.take();
+  if (context.resumed) {
+    sizes = context.start.totals.sizes;
+    sizes.resize(max_size + 1);
+  } else {
+    context.start.totals.counts = size_counts(sizes);
+    context.start.totals.sizes = sizes;
+  }
+
+  std::vector<size_t> ours;
+  for (size_t i = options.shardIndex; i < subtrees.size(); i += options.shardCount) {
+    if (!context.start.done[i]) {
+      ours.push_back(i);
+    }
+  }
+  context.start_checkpoint();
+  if (context.progress) {
+    context.progress->set_total_units(ours.size());
+  }
+  std::vector<std::vector<SizeTally>> finished(num_threads, std::vector<SizeTally>(max_size + 1));
+  WorkStealingPool pool(num_threads);
+  pool.run(ours.size(), [&](size_t task, size_t worker) {
+    context.time_thread(worker);
+    enumerator.search(subtrees[ours[task]], sinks[worker]);
+    context.count_progress(worker, 0, 0, 1);
+    if (context.checkpoint) {
+      std::vector<SizeTally> counts = sinks[worker].take();
+      for (int size = 1; size <= max_size; ++size) {
+        finished[worker][size] += counts[size];
+      }
+      context.checkpoint->complete_task(ours[task], size_counts(counts), counts);
+    }
+  });
+
+  for (size_t i = 0; i <= num_threads; ++i) {
+    context.time_thread(i);
+    sinks[i].flush();
+    for (int size = 1; size <= max_size; ++size) {
+      sizes[size] += sinks[i].tallies[size];
+      if (i < num_threads) {
+        sizes[size] += finished[i][size];
+      }
+    }
+  }
+  context.time_thread(num_threads);
+
+  return size_counts(sizes);
+}
+
+// Prints the counts of polyforms that weren't checked, if any.
+void print_skipped(const Tally& total) {
+  if (total.num_not_simple > 0) {
+    cout << "Not simple: " << total.num_not_simple << "\n";
+  }
+  if (total.num_unchecked > 0) {
+    cout << "Unchecked: " << total.num_unchecked << "\n";
+  }
+}
+
+// Parses polyforms of the given grid from the input file, extracts their
+// boundary words and counts the isohedral tilers. Instantiated once per
+// grid so that parsing, tracing and checking all use that grid's types.
+template <typename grid>
+int run(const Options& options) {
+  CheckContext context(options, grid::grid_type);
+  if (!options.cachePath.empty()) {
+    if (!context.cache.open(options.cachePath, grid::grid_type, CHECKER_VERSION)) {
+      std::cerr << "Error opening cache file: " << options.cachePath << "\n";
+      return -1;
+    }
+    cout << "Loaded " << context.cache.loaded() << " cached results\n";
+  }
+
+  size_t num_threads = options.numThreads;
+  if (num_threads == 0) {
+    num_threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  if (!options.timing.empty()) {
+    context.phase_times.resize(num_threads + 1);
+  }
+  context.time_thread(num_threads);
+
+  auto start = std::chrono::high_resolution_clock::now();
+  Tally total;
+  std::vector<SizeTally> sizes;
+  PartialResult& partial = context.start.totals;
+  partial.grid = options.gridName;
+  partial.shard_index = options.shardIndex;
+  partial.shard_count = options.shardCount;
+  MappedFile mapped;
+  DecompressingReader reader;
+  bool is_word_input = false;
+  std::vector<char> streamed_words;
+  std::vector<const char*> blocks;
+  WordFileHeader word_header = {};
+  if (options.enumerateSize > 0) {
+    partial.source = "enumerate " + std::to_string(options.enumerateSize);
+    partial.split = "enumerate";
+  } else {
+    bool is_mapped;
+    {
+      ScopedPhase timer(PHASE_READ);
+      is_mapped = mapped.open(options.fileName);
+    }
+    // Compressed files are streamed through a decompressing reader.
+    if (is_mapped && detect_compression(mapped.begin(), mapped.size()) != COMPRESSION_NONE) {
+      mapped.close();
+      is_mapped = false;
+    }
+    if (!is_mapped) {
+      std::string error;
+      if (!reader.open(options.fileName, error)) {
+        std::cerr << error << "\n";
+        return -1;
+      }
+    }
+    partial.source = options.fileName.substr(options.fileName.find_last_of('/') + 1);
+    context.start.input = stamp_input(options.fileName);
+    partial.split = reader.is_open() ? "lines" : "bytes";
+
+    // A word file that arrives through a pipe or compressed is recognized
+    // by its first decoded bytes and read into memory whole, since its
+    // blocks are indexed before checking starts.
+    const char* words_begin = mapped.begin();
+    const char* words_end = mapped.end();
+    if (reader.is_open()) {
+      char magic[sizeof(WordFileHeader::magic)];
+      if (is_word_file(magic, magic + reader.peek(magic, sizeof(magic)))) {
+        ScopedPhase timer(PHASE_READ);
+        std::istream& input = reader.stream();
+        size_t size = 0;
+        while (input) {
+          streamed_words.resize(size + STREAM_BLOCK);
+          input.read(streamed_words.data() + size, STREAM_BLOCK);
+          size += input.gcount();
+        }
+        streamed_words.resize(size);
+        words_begin = streamed_words.data();
+        words_end = words_begin + size;
+      }
+    }
+    is_word_input = is_word_file(words_begin, words_end);
+    if (is_word_input) {
+      std::string error;
+      if (!index_word_file(words_begin, words_end, grid::grid_type, blocks, word_header, error)) {
+        std::cerr << error << ": " << options.fileName << "\n";
+        return -1;
+      }
+      if (context.shape_output()) {
+        std::cerr << "--results and --filter need a text input, not a word file\n";
+        return -1;
+      }
+      partial.split = "blocks";
+    }
+  }
+
+  if (options.resume) {
+    CheckpointState state;
+    std::string error;
+    if (read_checkpoint(options.checkpointPath, state, error)) {
+      const PartialResult& saved = state.totals;
+      if (saved.grid != partial.grid || saved.source != partial.source || saved.split != partial.split ||
+          saved.shard_index != partial.shard_index || saved.shard_count != partial.shard_count) {
+        std::cerr << "Checkpoint " << options.checkpointPath << " belongs to a different run\n";
+        return -1;
+      }
+      if (state.input != context.start.input) {
+        std::cerr << "Input " << options.fileName << " has changed since checkpoint "
+                  << options.checkpointPath << " was written\n";
+        return -1;
+      }
+      context.start = state;
+      context.resumed = true;
+      cout << "Resuming from checkpoint: " << saved.counts.num_polyforms << " polyforms already checked\n";
+    } else if (!error.empty()) {
+      std::cerr << error << "\n";
+      return -1;
+    } else {
+      cout << "No checkpoint found, starting from the beginning\n";
+    }
+  }
+
+  if (!options.resultsPath.empty() && !context.results.open(options.resultsPath)) {
+    std::cerr << "Error opening results file: " << options.resultsPath << "\n";
+    return -1;
+  }
+  if (!options.filterPath.empty() && !context.filtered.open(options.filterPath)) {
+    std::cerr << "Error opening filter file: " << options.filterPath << "\n";
+    return -1;
+  }
+  if (options.progressInterval > 0) {
+    context.progress.reset(new ProgressReporter(num_threads, options.progressInterval, std::cerr));
+  }
+  if (options.enumerateSize > 0) {
+    std::cout << "Computing isohedral tilers among free polyforms of size 1 to "
+              << options.enumerateSize << "\n";
+    total = run_enumerated<grid>(context, num_threads, sizes);
+    print_size_table(std::cout, sizes);
+  } else {
+    // Parse polyforms from file
+    std::cout << "Computing isohedral tilers for " << options.fileName << "\n";
+    total = is_word_input ? run_word_file(blocks, word_header, context, num_threads)
+        : reader.is_open() ? run_streamed<grid>(reader.stream(), context, num_threads)
+        : run_mapped<grid>(mapped, context, num_threads);
+  }
+  if (context.progress) {
+    context.progress->stop();
+  }
+  std::string read_error;
+  if (!reader.close(read_error)) {
+    std::cerr << read_error << ": " << options.fileName << "\n";
+    return -1;
+  }
+  if (!context.results.close()) {
+    std::cerr << "Error writing results file: " << options.resultsPath << "\n";
+  }
+  if (!context.filtered.close()) {
+    std::cerr << "Error writing filter file: " << options.filterPath << "\n";
+  }
+  if (context.checkpoint && !context.checkpoint->stop()) {
+    std::cerr << "Error writing checkpoint file: " << options.checkpointPath << "\n";
+  }
+
+  cout << "Done extracting boundary words\n";
+  cout << "Num polyforms: " << total.num_polyforms << "\n";
+  print_skipped(total);
+  if (options.dedup) {
+    cout << "Num distinct: " << context.memo.size() << "\n";
+  }
+  if (context.cache.is_open()) {
+    cout << "Cache hits: " << context.cache_hits << "\n";
+    if (!context.cache.close()) {
+      std::cerr << "Error writing cache file: " << options.cachePath << "\n";
+    }
+  }
+  cout << "Num isohedral: " << total.num_isohedral << "\n\n";
+
+  if (!options.partialPath.empty()) {
+    partial.counts = total;
+    partial.sizes = sizes;
+    if (!write_partial(options.partialPath, partial)) {
+      std::cerr << "Error writing partial result file: " << options.partialPath << "\n";
+      return -1;
+    }
+  }
 
   auto end = std::chrono::high_resolution_clock::now();
-  auto duration = std::chrono::duration_cast<std::chrono::seconds>(end - start);
+  auto wall = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start);
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(wall);
 
-  // Convert duration to hours, minutes, and seconds
+  // Convert duration to hours, minutes, seconds and milliseconds
   auto hours = std::chrono::duration_cast<std::chrono::hours>(duration);
   duration -= hours;
   auto minutes = std::chrono::duration_cast<std::chrono::minutes>(duration);
   duration -= minutes;
   auto seconds = std::chrono::duration_cast<std::chrono::seconds>(duration);
+  duration -= seconds;
 
-  // Display the execution time in HH:MM:SS format
+  // Display the execution time in HH:MM:SS.mmm format
   std::cout << "Execution time: "
             << std::setw(2) << std::setfill('0') << hours.count() << ":"
             << std::setw(2) << std::setfill('0') << minutes.count() << ":"
-            << std::setw(2) << std::setfill('0') << seconds.count() << std::endl;
+            << std::setw(2) << std::setfill('0') << seconds.count() << "."
+            << std::setw(3) << std::setfill('0') << duration.count() << std::endl;
+
+  if (!options.timing.empty()) {
+    // Threads that entered any phase; the reading slot is only used when
+    // streaming.
+    PhaseTimes times;
+    size_t timed_threads = 0;
+    for (const PhaseTimes& thread_times: context.phase_times) {
+      times += thread_times;
+      timed_threads += std::any_of(std::begin(thread_times.calls), std::end(thread_times.calls),
+                                   [](uint64_t calls) { return calls > 0; });
+    }
+    thread_phase_times = nullptr;
+    std::cout << "\n";
+    if (options.timing == "json") {
+      print_phase_json(std::cout, times, wall.count(), num_threads);
+    } else {
+      print_phase_table(std::cout, times, wall.count(), timed_threads);
+    }
+  }
+  return 0;
+}
+
+// Traces the polyforms of a text input file and writes their boundary
+// words to a word file, which later runs read without parsing.
+template <typename grid>
+int convert(const std::string& input_path, const std::string& output_path) {
+  DecompressingReader reader;
+  std::string error;
+  if (!reader.open(input_path, error)) {
+    std::cerr << error << "\n";
+    return -1;
+  }
+  std::istream& input = reader.stream();
+  WordFileWriter writer;
+  if (!writer.open(output_path, grid::grid_type)) {
+    std::cerr << "Error opening word file: " << output_path << "\n";
+    return -1;
+  }
+  std::string line;
+  Shape<grid> shape;
+  BoundaryCorpus words;
+  size_t num_words = 0;
+  // A word file only holds the words to check. The lines and polyforms
+  // that a run would leave unchecked are only counted, the same way.
+  Tally tally;
+  while (std::getline(input, line)) {
+    ParseStatus status = parse_shape_line(line.data(), line.data() + line.size(), shape);
+    if (status == PARSE_EMPTY) {
+      continue;
+    }
+    trace_line(shape, status, words, tally);
+    if (words.size() == CHUNK_SIZE) {
+      writer.write_block(words);
+      num_words += words.size();
+      words.clear();
+    }
+  }
+  if (!words.empty()) {
+    writer.write_block(words);
+    num_words += words.size();
+  }
+  if (!reader.close(error)) {
+    std::cerr << error << ": " << input_path << "\n";
+    return -1;
+  }
+  writer.set_input_counts(tally.num_polyforms, tally.num_not_simple, tally.num_unchecked);
+  if (!writer.close()) {
+    std::cerr << "Error writing word file: " << output_path << "\n";
+    return -1;
+  }
+  cout << "Converted " << num_words << " polyforms to " << output_path << "\n";
+  print_skipped(tally);
+  return 0;
+}
+
+// Adds up the partial result files of the shards of one run and prints
+// the totals.
+int merge(const std::vector<std::string>& paths) {
+  std::vector<PartialResult> shards(paths.size());
+  std::string error;
+  for (size_t i = 0; i < paths.size(); ++i) {
+    if (!read_partial(paths[i], shards[i], error)) {
+      std::cerr << error << "\n";
+      return -1;
+    }
+  }
+  PartialResult total;
+  if (!merge_partials(shards, total, error)) {
+    std::cerr << error << "\n";
+    return -1;
+  }
+  cout << "Merged " << shards.size() << " shards of " << total.source << " (" << total.grid << ")\n";
+  if (!total.sizes.empty()) {
+    print_size_table(std::cout, total.sizes);
+  }
+  cout << "Num polyforms: " << total.counts.num_polyforms << "\n";
+  print_skipped(total.counts);
+  cout << "Num isohedral: " << total.counts.num_isohedral << "\n";
+  return 0;
+}
+
+// Prints the usage message of the checking mode.
+void print_usage() {
+  cout << "Usage: ./isohedral_e2e [options] <filename> [grid type. choices are: omino, hex, kite, iamond]\n"
+       << "       ./isohedral_e2e [options] --enumerate=<n> [grid type]\n"
+       << "       ./isohedral_e2e merge <partial result files>\n"
+       << "       ./isohedral_e2e convert <input file> <word file> <grid type>\n"
+       << "Options:\n"
+       << "  --enumerate=<n> check every free polyform of size 1 to n instead of reading a file\n"
+       << "  --shard=<i>/<n> handle only shard i of n of the input or enumeration\n"
+       << "  --partial=<file> write this run's counts to a partial result file for merge\n"
+       << "  --checkpoint=<file> save the run's progress to a file every minute\n"
+       << "  --checkpoint-interval=<s> seconds between checkpoints (default: 60)\n"
+       << "  --resume       continue from the progress saved in the checkpoint file\n"
+       << "  --results=<file> write each polyform's line number and result (1 if isohedral) to a file\n"
+       << "  --filter=<file> copy the lines of the polyforms that aren't isohedral to a file\n"
+       << "  --dedup        check each free polyform once, reusing results for repeats\n"
+       << "  --cache=<file> reuse and record results in a persistent cache file\n"
+       << "  --threads=<n>  number of checker threads (default: one per hardware thread)\n"
+       << "  --isa=<name>   letter kernels to use: scalar, sse4.2, avx2 or avx512 (default: best supported)\n"
+       << "  --progress[=<s>] print progress to stderr every s seconds (default: 5)\n"
+       << "  --timing[=json] print time spent in each phase as a table or as JSON\n";
+}
+
+int main(int argc, char **argv) {
+  if (argc >= 2 && std::string(argv[1]) == "merge") {
+    if (argc == 2) {
+      cout << "Usage: ./isohedral_e2e merge <partial result files>\n";
+      return -1;
+    }
+    return merge(std::vector<std::string>(argv + 2, argv + argc));
+  }
+  if (argc >= 2 && std::string(argv[1]) == "convert") {
+    if (argc != 5) {
+      cout << "Usage: ./isohedral_e2e convert <input file> <word file> <grid type>\n";
+      return -1;
+    }
+    std::string gridType = argv[4];
+    if (gridType == "omino") {
+      return convert<OminoGrid<int>>(argv[2], argv[3]);
+    } else if (gridType == "hex") {
+      return convert<HexGrid<int>>(argv[2], argv[3]);
+    } else if (gridType == "iamond") {
+      return convert<IamondGrid<int>>(argv[2], argv[3]);
+    } else if (gridType == "kite") {
+      return convert<KiteGrid<int>>(argv[2], argv[3]);
+    }
+    std::cerr << "Unknown grid type: " << gridType << "\n";
+    return -1;
+  }
+  cout << "argc: " << argc << "\n";
+  Options options;
+  std::vector<std::string> positional;
+  auto bad_value = [](const std::string& arg) {
+    cerr << "Invalid option value: " << arg << "\n";
+    print_usage();
+    return -1;
+  };
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--dedup") {
+      options.dedup = true;
+    } else if (arg.rfind("--cache=", 0) == 0) {
+      options.cachePath = arg.substr(8);
+    } else if (arg.rfind("--enumerate=", 0) == 0) {
+      if (!parse_number(arg.substr(12), options.enumerateSize)) {
+        return bad_value(arg);
+      }
+      if (options.enumerateSize < 1) {
+        cerr << "Enumeration size must be positive\n";
+        return -1;
+      }
+    } else if (arg.rfind("--shard=", 0) == 0) {
+      std::string shard = arg.substr(8);
+      size_t slash = shard.find('/');
+      if (slash == std::string::npos) {
+        cerr << "Shard must be given as <index>/<count>: " << shard << "\n";
+        return -1;
+      }
+      if (!parse_number(shard.substr(0, slash), options.shardIndex) ||
+          !parse_number(shard.substr(slash + 1), options.shardCount)) {
+        return bad_value(arg);
+      }
+      if (options.shardCount == 0 || options.shardIndex >= options.shardCount) {
+        cerr << "Shard index must be below the shard count: " << shard << "\n";
+        return -1;
+      }
+    } else if (arg.rfind("--partial=", 0) == 0) {
+      options.partialPath = arg.substr(10);
+    } else if (arg.rfind("--checkpoint=", 0) == 0) {
+      options.checkpointPath = arg.substr(13);
+    } else if (arg.rfind("--checkpoint-interval=", 0) == 0) {
+      if (!parse_number(arg.substr(22), options.checkpointInterval)) {
+        return bad_value(arg);
+      }
+      if (!(options.checkpointInterval > 0)) {
+        cerr << "Checkpoint interval must be positive\n";
+        return -1;
+      }
+    } else if (arg == "--resume") {
+      options.resume = true;
+    } else if (arg.rfind("--threads=", 0) == 0) {
+      if (!parse_number(arg.substr(10), options.numThreads)) {
+        return bad_value(arg);
+      }
+    } else if (arg.rfind("--results=", 0) == 0) {
+      options.resultsPath = arg.substr(10);
+    } else if (arg.rfind("--filter=", 0) == 0) {
+      options.filterPath = arg.substr(9);
+    } else if (arg == "--progress") {
+      options.progressInterval = 5;
+    } else if (arg.rfind("--progress=", 0) == 0) {
+      if (!parse_number(arg.substr(11), options.progressInterval)) {
+        return bad_value(arg);
+      }
+      if (!(options.progressInterval > 0)) {
+        cerr << "Progress interval must be positive\n";
+        return -1;
+      }
+    } else if (arg == "--timing") {
+      options.timing = "table";
+    } else if (arg.rfind("--timing=", 0) == 0) {
+      options.timing = arg.substr(9);
+      if (options.timing != "table" && options.timing != "json") {
+        cerr << "Unknown timing format: " << options.timing << "\n";
+        return -1;
+      }
+    } else if (arg.rfind("--isa=", 0) == 0) {
+      if (!select_letter_kernels(arg.substr(6))) {
+        cerr << "Unsupported instruction set: " << arg.substr(6) << "\n";
+        return -1;
+      }
+    } else if (arg.rfind("--", 0) == 0) {
+      cerr << "Unknown option: " << arg << "\n";
+      return -1;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+  if (options.resume && options.checkpointPath.empty()) {
+    cerr << "--resume needs a --checkpoint file\n";
+    return -1;
+  }
+  bool shape_output = !options.resultsPath.empty() || !options.filterPath.empty();
+  if (shape_output && (options.enumerateSize > 0 || options.resume)) {
+    cerr << "--results and --filter need a whole input file, not --enumerate or --resume\n";
+    return -1;
+  }
+  size_t num_positional = options.enumerateSize > 0 ? 1 : 2;
+  if (positional.size() != num_positional) {
+    print_usage();
+    return -1;
+  }
+  
+  if (options.enumerateSize == 0) {
+    options.fileName = positional[0];
+  }
+
+  std::string gridType = positional.back();
+  options.gridName = gridType;
+  if (gridType == "omino") {
+    return run<OminoGrid<int>>(options);
+  } else if (gridType == "hex") {
+    return run<HexGrid<int>>(options);
+  } else if (gridType == "iamond") {
+    return run<IamondGrid<int>>(options);
+  } else if (gridType == "kite") {
+    return run<KiteGrid<int>>(options);
+  }
+  std::cerr << "Unknown grid type: " << gridType << "\n";
+  return -1;
 }
 
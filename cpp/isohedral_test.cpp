@@ -0,0 +1,135 @@
+#include "boundary.h"
+#include "isohedral.h"
+#include "letter_kernels.h"
+#include "ominogrid.h"
+
+#include <iostream>
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Grows a random polyomino of the given size from the origin.
+Shape<OminoGrid<int>> randomPolyomino(int size, mt19937& rng) {
+  set<pair<int, int>> cells = {{0, 0}};
+  vector<pair<int, int>> dirs = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+  while ((int)cells.size() < size) {
+    auto it = cells.begin();
+    advance(it, rng() % cells.size());
+    auto d = dirs[rng() % 4];
+    cells.insert({it->first + d.first, it->second + d.second});
+  }
+  Shape<OminoGrid<int>> shape;
+  for (auto& c: cells) {
+    shape.add(c.first, c.second);
+  }
+  return shape;
+}
+
+// Compares every supported kernel set with the plain C++ one on random
+// codes, including codes outside the 16 entry tables.
+bool letterKernelsAgree(mt19937& rng) {
+  const LetterKernels& reference = *supported_letter_kernels().front();
+  uint8_t table[16];
+  for (auto& t: table) {
+    t = rng() % 12;
+  }
+  for (const LetterKernels* kernels: supported_letter_kernels()) {
+    for (size_t n = 0; n <= 150; ++n) {
+      vector<uint8_t> a(n), b(n), alive(n), len(n);
+      for (size_t i = 0; i < n; ++i) {
+        a[i] = (rng() % 20 == 0) ? NO_LETTER : rng() % 18;
+        b[i] = (rng() % 4 == 0) ? rng() % 18 : a[i];
+        alive[i] = rng() % 2;
+        len[i] = rng() % 8;
+      }
+      vector<uint8_t> alive1 = alive, len1 = len, alive2 = alive, len2 = len;
+      bool any1 = reference.match_step(a.data(), b.data(), alive1.data(), len1.data(), n);
+      bool any2 = kernels->match_step(a.data(), b.data(), alive2.data(), len2.data(), n);
+      vector<uint8_t> t1(n), t2(n);
+      reference.translate(a.data(), t1.data(), n, table);
+      kernels->translate(a.data(), t2.data(), n, table);
+      // Equal prefixes of every length exercise the tail handling.
+      vector<uint8_t> c = a;
+      if (n > 0) {
+        c[rng() % n] ^= 1;
+      }
+      if (any1 != any2 || alive1 != alive2 || len1 != len2 || t1 != t2 ||
+          reference.common_prefix(a.data(), c.data(), n) != kernels->common_prefix(a.data(), c.data(), n) ||
+          kernels->common_prefix(a.data(), a.data(), n) != n) {
+        cout << "Kernels " << kernels->name << " differ at length " << n << "\n";
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+int main() {
+  mt19937 rng(12345);
+  if (letterKernelsAgree(rng)) {
+    cout << "Letter kernel test case passed.\n";
+  } else {
+    cout << "Letter kernel test failed.\n";
+  }
+
+  IsohedralChecker checker = IsohedralChecker::forGrid(OMINO);
+
+  vector<boundaryword> words;
+  bool canonicalOk = true;
+  for (int i = 0; i < 400; ++i) {
+    Shape<OminoGrid<int>> shape = randomPolyomino(4 + i % 7, rng);
+    words.push_back(getBoundaryWord(shape));
+
+    // A quarter turn of the cells must not change the canonical form.
+    Shape<OminoGrid<int>> turned;
+    for (auto& p: shape) {
+      turned.add(-p.getY(), p.getX());
+    }
+    canonicalOk = canonicalOk &&
+      checker.canonical_form(words.back()) == checker.canonical_form(getBoundaryWord(turned));
+  }
+  if (canonicalOk) {
+    cout << "Canonical form test case passed.\n";
+  } else {
+    cout << "Canonical form test failed.\n";
+  }
+
+  // Every copy in the bank is a view written out twice; compare them
+  // with the same words built letter by letter.
+  bool bankOk = true;
+  for (const boundaryword& word: words) {
+    TransformBank bank = checker.transform_bank(word);
+    int n = word.size();
+    boundaryword reversed(word.rbegin(), word.rend());
+    boundaryword complemented = checker.inv_comp(word);
+    for (int k = 0; k < 2 * n; ++k) {
+      bankOk = bankOk &&
+        bank.reverse[k] == LetterTables::pack(reversed[k % n]) &&
+        bank.reverse_complement[k] == LetterTables::pack(complemented[k % n]) &&
+        bank.rotated[1][k] == LetterTables::pack(checker.iteratedCcw(word[k % n], 1)) &&
+        bank.reflected.at(0)[k] == LetterTables::pack({word[k % n].first, -word[k % n].second});
+    }
+  }
+  if (bankOk) {
+    cout << "Transform bank test case passed.\n";
+  } else {
+    cout << "Transform bank test failed.\n";
+  }
+
+  vector<bool> batch = checker.check_batch(words);
+  int mismatches = 0;
+  for (size_t i = 0; i < words.size(); ++i) {
+    if (batch[i] != checker.has_isohedral_tiling(words[i])) {
+      ++mismatches;
+    }
+  }
+  if (mismatches == 0) {
+    cout << "Batch check test case passed.\n";
+  } else {
+    cout << "Batch check test failed.\n";
+    cout << "Mismatches: " << mismatches << " of " << words.size() << "\n";
+  }
+}
@@ -3,6 +3,7 @@
 
 #include <cstdint>
 #include <iterator>
+#include <vector>
 
 #include "common.h"
 #include "geom.h"
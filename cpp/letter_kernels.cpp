@@ -0,0 +1,250 @@
+#include "letter_kernels.h"
+
+#include <atomic>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define LETTER_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+bool match_step_scalar(const uint8_t* a, const uint8_t* b, uint8_t* alive, uint8_t* len, size_t n) {
+  uint8_t any = 0;
+  for (size_t i = 0; i < n; ++i) {
+    alive[i] &= (a[i] == b[i]);
+    len[i] += alive[i];
+    any |= alive[i];
+  }
+  return any;
+}
+
+void translate_scalar(const uint8_t* src, uint8_t* dst, size_t n, const uint8_t* table) {
+  for (size_t i = 0; i < n; ++i) {
+    dst[i] = (src[i] < 16) ? table[src[i]] : NO_LETTER;
+  }
+}
+
+size_t common_prefix_scalar(const uint8_t* a, const uint8_t* b, size_t n) {
+  size_t i = 0;
+  while (i < n && a[i] == b[i]) {
+    ++i;
+  }
+  return i;
+}
+
+const LetterKernels SCALAR = {"scalar", match_step_scalar, translate_scalar, common_prefix_scalar};
+
+#ifdef LETTER_KERNELS_X86
+
+// 16 lanes per step. PSHUFB looks up all 16 letters in a register-held
+// table at once.
+
+__attribute__((target("sse4.2")))
+bool match_step_sse(const uint8_t* a, const uint8_t* b, uint8_t* alive, uint8_t* len, size_t n) {
+  __m128i any = _mm_setzero_si128();
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i)),
+                                _mm_loadu_si128((const __m128i*)(b + i)));
+    __m128i live = _mm_and_si128(_mm_loadu_si128((const __m128i*)(alive + i)), eq);
+    _mm_storeu_si128((__m128i*)(alive + i), live);
+    _mm_storeu_si128((__m128i*)(len + i),
+                     _mm_add_epi8(_mm_loadu_si128((const __m128i*)(len + i)), live));
+    any = _mm_or_si128(any, live);
+  }
+  bool result = !_mm_testz_si128(any, any);
+  return match_step_scalar(a + i, b + i, alive + i, len + i, n - i) || result;
+}
+
+__attribute__((target("sse4.2")))
+void translate_sse(const uint8_t* src, uint8_t* dst, size_t n, const uint8_t* table) {
+  const __m128i lut = _mm_loadu_si128((const __m128i*)table);
+  const __m128i top = _mm_set1_epi8(15);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m128i x = _mm_loadu_si128((const __m128i*)(src + i));
+    __m128i in_table = _mm_cmpeq_epi8(_mm_min_epu8(x, top), x);
+    __m128i y = _mm_or_si128(_mm_shuffle_epi8(lut, x), _mm_andnot_si128(in_table, _mm_set1_epi8(-1)));
+    _mm_storeu_si128((__m128i*)(dst + i), y);
+  }
+  translate_scalar(src + i, dst + i, n - i, table);
+}
+
+__attribute__((target("sse4.2")))
+size_t common_prefix_sse(const uint8_t* a, const uint8_t* b, size_t n) {
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    unsigned diff = 0xffff ^ _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(a + i)),
+                                                              _mm_loadu_si128((const __m128i*)(b + i))));
+    if (diff) {
+      return i + __builtin_ctz(diff);
+    }
+  }
+  return i + common_prefix_scalar(a + i, b + i, n - i);
+}
+
+const LetterKernels SSE = {"sse4.2", match_step_sse, translate_sse, common_prefix_sse};
+
+// 32 lanes per step. VPSHUFB shuffles within 128-bit halves, so the table
+// is broadcast to both.
+
+__attribute__((target("avx2")))
+bool match_step_avx2(const uint8_t* a, const uint8_t* b, uint8_t* alive, uint8_t* len, size_t n) {
+  __m256i any = _mm256_setzero_si256();
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(a + i)),
+                                   _mm256_loadu_si256((const __m256i*)(b + i)));
+    __m256i live = _mm256_and_si256(_mm256_loadu_si256((const __m256i*)(alive + i)), eq);
+    _mm256_storeu_si256((__m256i*)(alive + i), live);
+    _mm256_storeu_si256((__m256i*)(len + i),
+                        _mm256_add_epi8(_mm256_loadu_si256((const __m256i*)(len + i)), live));
+    any = _mm256_or_si256(any, live);
+  }
+  bool result = !_mm256_testz_si256(any, any);
+  return match_step_sse(a + i, b + i, alive + i, len + i, n - i) || result;
+}
+
+__attribute__((target("avx2")))
+void translate_avx2(const uint8_t* src, uint8_t* dst, size_t n, const uint8_t* table) {
+  const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)table));
+  const __m256i top = _mm256_set1_epi8(15);
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    __m256i x = _mm256_loadu_si256((const __m256i*)(src + i));
+    __m256i in_table = _mm256_cmpeq_epi8(_mm256_min_epu8(x, top), x);
+    __m256i y = _mm256_or_si256(_mm256_shuffle_epi8(lut, x),
+                                _mm256_andnot_si256(in_table, _mm256_set1_epi8(-1)));
+    _mm256_storeu_si256((__m256i*)(dst + i), y);
+  }
+  translate_sse(src + i, dst + i, n - i, table);
+}
+
+__attribute__((target("avx2")))
+size_t common_prefix_avx2(const uint8_t* a, const uint8_t* b, size_t n) {
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32) {
+    unsigned diff = ~unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(
+        _mm256_loadu_si256((const __m256i*)(a + i)), _mm256_loadu_si256((const __m256i*)(b + i)))));
+    if (diff) {
+      return i + __builtin_ctz(diff);
+    }
+  }
+  return i + common_prefix_sse(a + i, b + i, n - i);
+}
+
+const LetterKernels AVX2 = {"avx2", match_step_avx2, translate_avx2, common_prefix_avx2};
+
+// 64 lanes per step, a whole lane block row. Masked loads and stores
+// cover the tail, so there is no scalar remainder.
+
+__attribute__((target("avx512f,avx512bw")))
+bool match_step_avx512(const uint8_t* a, const uint8_t* b, uint8_t* alive, uint8_t* len, size_t n) {
+  __mmask64 any = 0;
+  for (size_t i = 0; i < n; i += 64) {
+    __mmask64 k = (n - i >= 64) ? ~__mmask64(0) : (__mmask64(1) << (n - i)) - 1;
+    __mmask64 eq = _mm512_mask_cmpeq_epi8_mask(k, _mm512_maskz_loadu_epi8(k, a + i),
+                                               _mm512_maskz_loadu_epi8(k, b + i));
+    __m512i live = _mm512_maskz_loadu_epi8(eq, alive + i);
+    _mm512_mask_storeu_epi8(alive + i, k, live);
+    _mm512_mask_storeu_epi8(len + i, k, _mm512_add_epi8(_mm512_maskz_loadu_epi8(k, len + i), live));
+    any |= _mm512_test_epi8_mask(live, live);
+  }
+  return any != 0;
+}
+
+__attribute__((target("avx512f,avx512bw")))
+void translate_avx512(const uint8_t* src, uint8_t* dst, size_t n, const uint8_t* table) {
+  // Zero-masked form: the unmasked broadcast merges into an undefined
+  // register, which GCC reports as uninitialized under -Wall.
+  const __m128i lane = _mm_loadu_si128((const __m128i*)table);
+  const __m512i lut = _mm512_maskz_broadcast_i32x4(__mmask16(0xFFFF), lane);
+  const __m512i top = _mm512_set1_epi8(15);
+  const __m512i none = _mm512_set1_epi8(char(NO_LETTER));
+  for (size_t i = 0; i < n; i += 64) {
+    __mmask64 k = (n - i >= 64) ? ~__mmask64(0) : (__mmask64(1) << (n - i)) - 1;
+    __m512i x = _mm512_maskz_loadu_epi8(k, src + i);
+    __mmask64 in_table = _mm512_cmple_epu8_mask(x, top);
+    __m512i y = _mm512_mask_shuffle_epi8(none, in_table, lut, x);
+    _mm512_mask_storeu_epi8(dst + i, k, y);
+  }
+}
+
+__attribute__((target("avx512f,avx512bw")))
+size_t common_prefix_avx512(const uint8_t* a, const uint8_t* b, size_t n) {
+  for (size_t i = 0; i < n; i += 64) {
+    __mmask64 k = (n - i >= 64) ? ~__mmask64(0) : (__mmask64(1) << (n - i)) - 1;
+    __mmask64 diff = _mm512_mask_cmpneq_epi8_mask(k, _mm512_maskz_loadu_epi8(k, a + i),
+                                                  _mm512_maskz_loadu_epi8(k, b + i));
+    if (diff) {
+      return i + __builtin_ctzll(diff);
+    }
+  }
+  return n;
+}
+
+const LetterKernels AVX512 = {"avx512", match_step_avx512, translate_avx512, common_prefix_avx512};
+
+#endif  // LETTER_KERNELS_X86
+
+std::vector<const LetterKernels*> detect_supported() {
+  std::vector<const LetterKernels*> supported = {&SCALAR};
+#ifdef LETTER_KERNELS_X86
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.2")) {
+    supported.push_back(&SSE);
+    if (__builtin_cpu_supports("avx2")) {
+      supported.push_back(&AVX2);
+      if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")) {
+        supported.push_back(&AVX512);
+      }
+    }
+  }
+#endif
+  return supported;
+}
+
+#ifndef POLYISO_LIBRARY
+// The active kernels. A function-local static, so that static
+// initializers in other translation units never see it unset.
+std::atomic<const LetterKernels*>& active() {
+  static std::atomic<const LetterKernels*> kernels{supported_letter_kernels().back()};
+  return kernels;
+}
+#endif
+
+}  // namespace
+
+#ifdef POLYISO_LIBRARY
+
+// libpolyiso keeps no mutable global state and always uses the widest
+// supported kernels.
+const LetterKernels& letter_kernels() {
+  return *supported_letter_kernels().back();
+}
+
+#else
+
+const LetterKernels& letter_kernels() {
+  return *active().load(std::memory_order_relaxed);
+}
+
+#endif  // POLYISO_LIBRARY
+
+const std::vector<const LetterKernels*>& supported_letter_kernels() {
+  static const std::vector<const LetterKernels*> supported = detect_supported();
+  return supported;
+}
+
+#ifndef POLYISO_LIBRARY
+bool select_letter_kernels(const std::string& name) {
+  for (const LetterKernels* kernels: supported_letter_kernels()) {
+    if (name == kernels->name) {
+      active().store(kernels, std::memory_order_relaxed);
+      return true;
+    }
+  }
+  return false;
+}
+#endif
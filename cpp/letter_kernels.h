@@ -0,0 +1,43 @@
+#ifndef LETTER_KERNELS_H
+#define LETTER_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A letter code that matches nothing, for transforms the grid lacks.
+constexpr uint8_t NO_LETTER = 0xff;
+
+// Inner loops of the checker on byte letter codes, in one version per
+// instruction set. The best version the CPU supports is chosen when the
+// program starts; every version gives identical results.
+struct LetterKernels {
+  const char* name;
+
+  // One comparison step of a lockstep match over n lanes: for every i,
+  // alive[i] &= (a[i] == b[i]) and len[i] += alive[i], where alive holds
+  // 0 or 1. Returns whether any lane is still alive.
+  bool (*match_step)(const uint8_t* a, const uint8_t* b, uint8_t* alive, uint8_t* len, size_t n);
+
+  // dst[i] = table[src[i]] for a 16 entry table. Codes of 16 or more map
+  // to NO_LETTER.
+  void (*translate)(const uint8_t* src, uint8_t* dst, size_t n, const uint8_t* table);
+
+  // Returns the length of the longest common prefix of a and b, both of
+  // length at least n, capped at n.
+  size_t (*common_prefix)(const uint8_t* a, const uint8_t* b, size_t n);
+};
+
+// The active kernels.
+const LetterKernels& letter_kernels();
+
+// The kernels this CPU supports, from the plain C++ version to the widest.
+const std::vector<const LetterKernels*>& supported_letter_kernels();
+
+// Makes the supported kernels with the given name active. Returns false
+// if there are none. Must be called before checker threads start. Not
+// part of libpolyiso, which always uses the widest kernels.
+bool select_letter_kernels(const std::string& name);
+
+#endif // LETTER_KERNELS_H
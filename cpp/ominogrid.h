@@ -1,6 +1,8 @@
 #ifndef OMINOGRID_H
 #define OMINOGRID_H
 
+#include <vector>
+
 #include "common.h"
 #include "geom.h"
 
@@ -110,5 +112,43 @@ public:
 	static const point<int8_t> edge_neighbours[4];
 };
 
+template<typename coord>
+const point<coord> OminoGrid<coord>::origins[1] = {
+	{ 0, 0 }
+};
+
+template<typename coord>
+const point<int8_t> OminoGrid<coord>::all_neighbours[8] = {
+		{ -1, -1 },
+		{ 0, -1 },
+		{ 1, -1 },
+		{ -1, 0 },
+		{ 1, 0 },
+		{ -1, 1 },
+		{ 0, 1 },
+		{ 1, 1 } };
+
+template<typename coord>
+const point<int8_t> OminoGrid<coord>::edge_neighbours[4] = {
+		{ 1, 0 },
+		{ 0, 1 },
+		{ -1, 0 },
+		{ 0, -1 } };
+
+template<typename coord>
+const size_t OminoGrid<coord>::num_orientations = 8;
+
+template<typename coord>
+const xform<int8_t> OminoGrid<coord>::orientations[8] = {
+	{ 1, 0, 0,     0, 1, 0 },
+	{ 0, -1, 0,    1, 0, 0 },
+	{ -1, 0, 0,    0, -1, 0 },
+	{ 0, 1, 0,     -1, 0, 0 },
+
+	{ -1, 0, 0,    0, 1, 0 },
+	{ 0, -1, 0,    -1, 0, 0 },
+	{ 1, 0, 0,     0, -1, 0 },
+	{ 0, 1, 0,     1, 0, 0 } };
+
 #endif // OMINOGRID_H
 
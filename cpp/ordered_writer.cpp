@@ -0,0 +1,90 @@
+#include "ordered_writer.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+// Write once this much text is ready, unless closing.
+const size_t WRITE_THRESHOLD = 1 << 20;
+
+bool write_all(int fd, const char* p, size_t size) {
+  while (size > 0) {
+    ssize_t written = ::write(fd, p, size);
+    if (written < 0) {
+      return false;
+    }
+    p += written;
+    size -= written;
+  }
+  return true;
+}
+
+}  // namespace
+
+OrderedWriter::~OrderedWriter() {
+  close();
+}
+
+bool OrderedWriter::open(const std::string& path) {
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd_ == -1) {
+    return false;
+  }
+  thread_ = std::thread([this]() { run(); });
+  return true;
+}
+
+void OrderedWriter::submit(size_t seq, std::string text) {
+  bool wake;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (seq != next_seq_) {
+      pending_.emplace(seq, std::move(text));
+      return;
+    }
+    ready_ += text;
+    ++next_seq_;
+    for (auto it = pending_.begin(); it != pending_.end() && it->first == next_seq_;
+         it = pending_.erase(it), ++next_seq_) {
+      ready_ += it->second;
+    }
+    wake = ready_.size() >= WRITE_THRESHOLD;
+  }
+  if (wake) {
+    wake_.notify_one();
+  }
+}
+
+bool OrderedWriter::close() {
+  if (fd_ == -1) {
+    return !failed_;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closing_ = true;
+  }
+  wake_.notify_one();
+  thread_.join();
+  failed_ = ::close(fd_) != 0 || failed_;
+  fd_ = -1;
+  return !failed_;
+}
+
+void OrderedWriter::run() {
+  std::string block;
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this]() { return closing_ || ready_.size() >= WRITE_THRESHOLD; });
+    bool last = closing_;
+    block.clear();
+    block.swap(ready_);
+    lock.unlock();
+    bool written = write_all(fd_, block.data(), block.size());
+    lock.lock();
+    failed_ = failed_ || !written;
+    if (last) {
+      return;
+    }
+  }
+}
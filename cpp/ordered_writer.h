@@ -0,0 +1,54 @@
+#ifndef ORDERED_WRITER_H
+#define ORDERED_WRITER_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Writes blocks of text produced by parallel workers to a file in their
+// input order.
+//
+// Workers submit numbered blocks in any order. Blocks that arrive early
+// wait in a reorder buffer until the ones before them are in, and a
+// background thread gathers the ready blocks into large writes, so a
+// worker only holds the lock long enough to hand its block over and
+// never waits on the disk.
+class OrderedWriter {
+ public:
+  OrderedWriter() = default;
+  OrderedWriter(const OrderedWriter&) = delete;
+  OrderedWriter& operator=(const OrderedWriter&) = delete;
+  ~OrderedWriter();
+
+  // Creates or truncates the file at path. Returns false if it cannot
+  // be opened.
+  bool open(const std::string& path);
+
+  // Hands over block seq. Blocks are numbered from 0, and every number
+  // must be submitted once, even if its text is empty.
+  void submit(size_t seq, std::string text);
+
+  // Writes the remaining blocks up to the first missing one and closes
+  // the file. Returns false if any write failed.
+  bool close();
+
+ private:
+  void run();
+
+  int fd_ = -1;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool closing_ = false;
+  bool failed_ = false;
+  // Blocks waiting for an earlier one, and the in-order text ready to
+  // be written.
+  size_t next_seq_ = 0;
+  std::map<size_t, std::string> pending_;
+  std::string ready_;
+  std::thread thread_;
+};
+
+#endif // ORDERED_WRITER_H
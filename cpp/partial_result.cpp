@@ -0,0 +1,163 @@
+#include "partial_result.h"
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+const char MAGIC[] = "isohedral-partial";
+const int FORMAT_VERSION = 1;
+
+}  // namespace
+
+void print_size_table(std::ostream& out, const std::vector<SizeTally>& sizes) {
+  out << std::setw(6) << "Size" << std::setw(14) << "Free" << std::setw(10) << "Holey"
+      << std::setw(14) << "Isohedral" << std::setw(18) << "Fixed isohedral" << std::setw(10) << "Too long"
+      << "\n";
+  for (size_t size = 1; size < sizes.size(); ++size) {
+    const SizeTally& tally = sizes[size];
+    out << std::setw(6) << size << std::setw(14) << tally.num_free
+        << std::setw(10) << tally.num_holey << std::setw(14) << tally.num_isohedral
+        << std::setw(18) << tally.num_fixed_isohedral << std::setw(10) << tally.num_too_long << "\n";
+  }
+}
+
+void write_partial_fields(std::ostream& out, const PartialResult& result) {
+  out << "grid " << result.grid << "\n"
+      << "source " << result.source << "\n"
+      << "split " << result.split << "\n"
+      << "shard " << result.shard_index << " " << result.shard_count << "\n"
+      << "polyforms " << result.counts.num_polyforms << "\n"
+      << "isohedral " << result.counts.num_isohedral << "\n"
+      << "not-simple " << result.counts.num_not_simple << "\n"
+      << "unchecked " << result.counts.num_unchecked << "\n";
+  for (size_t size = 1; size < result.sizes.size(); ++size) {
+    const SizeTally& tally = result.sizes[size];
+    out << "size " << size << " " << tally.num_free << " " << tally.num_holey << " "
+        << tally.num_isohedral << " " << tally.num_fixed_isohedral << " " << tally.num_too_long << "\n";
+  }
+}
+
+bool parse_partial_field(const std::string& key, const std::string& value, PartialResult& result) {
+  std::istringstream fields(value);
+  if (key == "grid") {
+    result.grid = value;
+  } else if (key == "source") {
+    result.source = value;
+  } else if (key == "split") {
+    result.split = value;
+  } else if (key == "shard") {
+    return bool(fields >> result.shard_index >> result.shard_count) &&
+           result.shard_index < result.shard_count;
+  } else if (key == "polyforms") {
+    return bool(fields >> result.counts.num_polyforms);
+  } else if (key == "isohedral") {
+    return bool(fields >> result.counts.num_isohedral);
+  } else if (key == "not-simple") {
+    return bool(fields >> result.counts.num_not_simple);
+  } else if (key == "unchecked") {
+    return bool(fields >> result.counts.num_unchecked);
+  } else if (key == "size") {
+    size_t size;
+    SizeTally tally;
+    if (!(fields >> size >> tally.num_free >> tally.num_holey >> tally.num_isohedral >>
+          tally.num_fixed_isohedral) || size == 0) {
+      return false;
+    }
+    // Written since too long polyforms were counted; 0 when missing.
+    if (!(fields >> tally.num_too_long)) {
+      tally.num_too_long = 0;
+    }
+    if (result.sizes.size() <= size) {
+      result.sizes.resize(size + 1);
+    }
+    result.sizes[size] = tally;
+  }
+  return true;
+}
+
+bool write_partial(const std::string& path, const PartialResult& result) {
+  std::ofstream out(path);
+  if (!out) {
+    return false;
+  }
+  out << MAGIC << " " << FORMAT_VERSION << "\n";
+  write_partial_fields(out, result);
+  out.close();
+  return bool(out);
+}
+
+bool read_partial(const std::string& path, PartialResult& result, std::string& error) {
+  std::ifstream in(path);
+  if (!in) {
+    error = "Error opening partial result file: " + path;
+    return false;
+  }
+  result = PartialResult();
+  std::string line;
+  std::string magic;
+  int version = 0;
+  std::getline(in, line);
+  std::istringstream header(line);
+  if (!(header >> magic >> version) || magic != MAGIC || version != FORMAT_VERSION) {
+    error = "Not a partial result file: " + path;
+    return false;
+  }
+  while (std::getline(in, line)) {
+    if (line.empty()) {
+      continue;
+    }
+    std::string key = line.substr(0, line.find(' '));
+    std::string value = line.size() > key.size() ? line.substr(key.size() + 1) : "";
+    if (!parse_partial_field(key, value, result)) {
+      error = "Malformed line in " + path + ": " + line;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool merge_partials(const std::vector<PartialResult>& shards, PartialResult& total, std::string& error) {
+  if (shards.empty()) {
+    error = "No partial results to merge";
+    return false;
+  }
+  const PartialResult& first = shards.front();
+  total = PartialResult();
+  total.grid = first.grid;
+  total.source = first.source;
+  total.split = first.split;
+  total.shard_count = 1;
+  std::vector<bool> seen(first.shard_count);
+  for (const PartialResult& shard: shards) {
+    if (shard.grid != first.grid || shard.source != first.source || shard.split != first.split ||
+        shard.shard_count != first.shard_count) {
+      error = "Partial results come from different runs";
+      return false;
+    }
+    if (seen[shard.shard_index]) {
+      error = "Shard " + std::to_string(shard.shard_index) + " appears twice";
+      return false;
+    }
+    seen[shard.shard_index] = true;
+    total.counts += shard.counts;
+    if (total.sizes.size() < shard.sizes.size()) {
+      total.sizes.resize(shard.sizes.size());
+    }
+    for (size_t size = 1; size < shard.sizes.size(); ++size) {
+      total.sizes[size] += shard.sizes[size];
+    }
+  }
+  std::string missing;
+  for (size_t i = 0; i < seen.size(); ++i) {
+    if (!seen[i]) {
+      missing += (missing.empty() ? "" : ", ") + std::to_string(i);
+    }
+  }
+  if (!missing.empty()) {
+    error = "Missing shards of " + std::to_string(first.shard_count) + ": " + missing;
+    return false;
+  }
+  return true;
+}
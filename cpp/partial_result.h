@@ -0,0 +1,106 @@
+#ifndef PARTIAL_RESULT_H
+#define PARTIAL_RESULT_H
+
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Counts for the enumerated free polyforms of one size.
+struct SizeTally {
+  size_t num_free = 0;
+  // Polyforms whose boundary isn't a simple closed curve, which have
+  // holes and so can't tile.
+  size_t num_holey = 0;
+  size_t num_isohedral = 0;
+  // Isohedral polyforms counted once per fixed (translation class) copy,
+  // comparable to counts from fixed polyform files.
+  size_t num_fixed_isohedral = 0;
+  // Simple polyforms whose boundary is too long to check.
+  size_t num_too_long = 0;
+
+  SizeTally& operator+=(const SizeTally& other) {
+    num_free += other.num_free;
+    num_holey += other.num_holey;
+    num_isohedral += other.num_isohedral;
+    num_fixed_isohedral += other.num_fixed_isohedral;
+    num_too_long += other.num_too_long;
+    return *this;
+  }
+};
+
+// Counts for a part of a run. Polyforms whose boundary isn't simple are
+// among num_polyforms but aren't checked, since they can't tile.
+// Unchecked inputs are lines that couldn't be parsed or traced, which
+// aren't polyforms, and polyforms whose boundary is too long to check,
+// which are.
+struct Tally {
+  size_t num_polyforms = 0;
+  size_t num_isohedral = 0;
+  size_t num_not_simple = 0;
+  size_t num_unchecked = 0;
+
+  Tally& operator+=(const Tally& other) {
+    num_polyforms += other.num_polyforms;
+    num_isohedral += other.num_isohedral;
+    num_not_simple += other.num_not_simple;
+    num_unchecked += other.num_unchecked;
+    return *this;
+  }
+};
+
+// Writes the per-size counts of sizes 1 and up as an aligned table.
+void print_size_table(std::ostream& out, const std::vector<SizeTally>& sizes);
+
+// The result of one shard of a run, which merge_partials adds up with
+// the other shards of the same run.
+//
+// The file is plain text, one "key value..." line per field:
+//
+//   isohedral-partial 1
+//   grid omino
+//   source omino10.txt
+//   split bytes
+//   shard 3 8
+//   polyforms 4557
+//   isohedral 3132
+//   not-simple 0
+//   unchecked 0
+//   size 10 4655 195 3026 23678 0
+//
+// split names how the work was divided: "bytes" for line-aligned byte
+// ranges of a mapped file, "lines" for line numbers modulo the shard
+// count of a streamed input, or "enumerate" for subtrees of the
+// enumeration. Size lines are only written for enumerations and hold
+// the fields of SizeTally. Files without the not-simple and unchecked
+// lines count those as 0.
+struct PartialResult {
+  std::string grid;
+  std::string source;
+  std::string split;
+  size_t shard_index = 0;
+  size_t shard_count = 1;
+  Tally counts;
+  // Indexed by polyform size; entry 0 is unused.
+  std::vector<SizeTally> sizes;
+};
+
+bool write_partial(const std::string& path, const PartialResult& result);
+
+// Writes the fields of result, one line each, without the file header.
+void write_partial_fields(std::ostream& out, const PartialResult& result);
+
+// Parses one field line of a partial result into result. Returns false if
+// the line is a known field with malformed values; unknown keys are left
+// to the caller.
+bool parse_partial_field(const std::string& key, const std::string& value, PartialResult& result);
+
+// Returns false and sets error if the file can't be read or is malformed.
+bool read_partial(const std::string& path, PartialResult& result, std::string& error);
+
+// Adds up the shards of one run into total. Returns false and sets error
+// if the shards belong to different runs, repeat a shard, or don't
+// cover every shard of the run.
+bool merge_partials(const std::vector<PartialResult>& shards, PartialResult& total, std::string& error);
+
+#endif // PARTIAL_RESULT_H
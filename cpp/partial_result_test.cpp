@@ -0,0 +1,168 @@
+#include "partial_result.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+// A shard of an enumeration of ominoes up to size 2, with distinct counts
+// per shard so that a wrong sum shows.
+PartialResult makeShard(size_t index, size_t count) {
+  PartialResult shard;
+  shard.grid = "omino";
+  shard.source = "enumerate 2";
+  shard.split = "enumerate";
+  shard.shard_index = index;
+  shard.shard_count = count;
+  shard.counts.num_polyforms = 10 + index;
+  shard.counts.num_isohedral = 5 + index;
+  shard.counts.num_not_simple = 2 + index;
+  shard.counts.num_unchecked = 1 + index;
+  shard.sizes.resize(3);
+  shard.sizes[2].num_free = 3 + index;
+  shard.sizes[2].num_holey = index;
+  shard.sizes[2].num_isohedral = 1;
+  shard.sizes[2].num_fixed_isohedral = 2;
+  shard.sizes[2].num_too_long = index;
+  return shard;
+}
+
+bool sameCounts(const Tally& lhs, const Tally& rhs) {
+  return lhs.num_polyforms == rhs.num_polyforms && lhs.num_isohedral == rhs.num_isohedral &&
+         lhs.num_not_simple == rhs.num_not_simple && lhs.num_unchecked == rhs.num_unchecked;
+}
+
+bool sameSizes(const vector<SizeTally>& lhs, const vector<SizeTally>& rhs) {
+  if (lhs.size() != rhs.size()) {
+    return false;
+  }
+  for (size_t size = 1; size < lhs.size(); ++size) {
+    const SizeTally& a = lhs[size];
+    const SizeTally& b = rhs[size];
+    if (a.num_free != b.num_free || a.num_holey != b.num_holey || a.num_isohedral != b.num_isohedral ||
+        a.num_fixed_isohedral != b.num_fixed_isohedral || a.num_too_long != b.num_too_long) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Writes text to a new temporary file and returns its path.
+string writeTemp(const string& text) {
+  char path[] = "/tmp/partial_result_testXXXXXX";
+  int fd = mkstemp(path);
+  if (fd == -1 || write(fd, text.data(), text.size()) != ssize_t(text.size())) {
+    return "";
+  }
+  close(fd);
+  return path;
+}
+
+// Reads the partial result file with the given contents.
+bool readText(const string& text, PartialResult& result, string& error) {
+  string path = writeTemp(text);
+  bool ok = !path.empty() && read_partial(path, result, error);
+  unlink(path.c_str());
+  return ok;
+}
+
+int main() {
+  // Shards merge in any order into the sum of their counts.
+  bool mergeOk = true;
+  {
+    vector<PartialResult> shards = {makeShard(2, 3), makeShard(0, 3), makeShard(1, 3)};
+    PartialResult total;
+    string error;
+    Tally expected = {33, 18, 9, 6};
+    mergeOk = merge_partials(shards, total, error) && sameCounts(total.counts, expected) &&
+              total.sizes.size() == 3 && total.sizes[2].num_free == 12 && total.sizes[2].num_holey == 3 &&
+              total.sizes[2].num_isohedral == 3 && total.sizes[2].num_fixed_isohedral == 6 &&
+              total.sizes[2].num_too_long == 3 && total.grid == "omino" && total.shard_count == 1;
+  }
+  if (mergeOk) {
+    cout << "Merge test case passed.\n";
+  } else {
+    cout << "Merge test failed.\n";
+  }
+
+  // Merging refuses a missing shard, a repeated shard and shards of
+  // different runs.
+  bool mismatchOk = true;
+  {
+    PartialResult total;
+    string error;
+    mismatchOk = !merge_partials({makeShard(0, 3), makeShard(2, 3)}, total, error) &&
+                 error == "Missing shards of 3: 1" && mismatchOk;
+    mismatchOk = !merge_partials({makeShard(0, 2), makeShard(1, 2), makeShard(1, 2)}, total, error) &&
+                 error == "Shard 1 appears twice" && mismatchOk;
+    mismatchOk = !merge_partials({makeShard(0, 2), makeShard(1, 3)}, total, error) &&
+                 error == "Partial results come from different runs" && mismatchOk;
+    PartialResult other = makeShard(1, 2);
+    other.grid = "hex";
+    mismatchOk = !merge_partials({makeShard(0, 2), other}, total, error) &&
+                 error == "Partial results come from different runs" && mismatchOk;
+    other = makeShard(1, 2);
+    other.source = "enumerate 3";
+    mismatchOk = !merge_partials({makeShard(0, 2), other}, total, error) &&
+                 error == "Partial results come from different runs" && mismatchOk;
+    other = makeShard(1, 2);
+    other.split = "lines";
+    mismatchOk = !merge_partials({makeShard(0, 2), other}, total, error) &&
+                 error == "Partial results come from different runs" && mismatchOk;
+    mismatchOk = !merge_partials({}, total, error) && mismatchOk;
+  }
+  if (mismatchOk) {
+    cout << "Merge mismatch test case passed.\n";
+  } else {
+    cout << "Merge mismatch test failed.\n";
+  }
+
+  // A written partial result reads back unchanged, files written before
+  // the not-simple, unchecked and too long counts read them as 0, and
+  // malformed files are refused.
+  bool fileOk = true;
+  {
+    char path[] = "/tmp/partial_result_testXXXXXX";
+    int fd = mkstemp(path);
+    close(fd);
+    PartialResult written = makeShard(1, 4);
+    PartialResult read;
+    string error;
+    fileOk = write_partial(path, written) && read_partial(path, read, error) &&
+             read.grid == written.grid && read.source == written.source && read.split == written.split &&
+             read.shard_index == 1 && read.shard_count == 4 && sameCounts(read.counts, written.counts) &&
+             sameSizes(read.sizes, written.sizes);
+    unlink(path);
+
+    fileOk = readText("isohedral-partial 1\ngrid omino\nsource a.txt\nsplit bytes\nshard 0 2\n"
+                      "polyforms 7\nisohedral 3\nsize 4 5 0 3 9\n", read, error) &&
+             read.counts.num_polyforms == 7 && read.counts.num_not_simple == 0 &&
+             read.counts.num_unchecked == 0 && read.sizes.size() == 5 && read.sizes[4].num_fixed_isohedral == 9 &&
+             read.sizes[4].num_too_long == 0 && fileOk;
+
+    const char* malformed[] = {
+      "isohedral-checkpoint 1\n",
+      "isohedral-partial 2\n",
+      "isohedral-partial 1\nshard 2 2\n",
+      "isohedral-partial 1\nshard 1\n",
+      "isohedral-partial 1\npolyforms many\n",
+      "isohedral-partial 1\nunchecked\n",
+      "isohedral-partial 1\nsize 0 1 0 1 1\n",
+      "isohedral-partial 1\nsize 3 1 0\n",
+    };
+    for (const char* text: malformed) {
+      fileOk = !readText(text, read, error) && !error.empty() && fileOk;
+    }
+    fileOk = !read_partial("/nonexistent/partial.txt", read, error) && fileOk;
+  }
+  if (fileOk) {
+    cout << "Partial result file test case passed.\n";
+  } else {
+    cout << "Partial result file test failed.\n";
+  }
+}
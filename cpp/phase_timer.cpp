@@ -0,0 +1,72 @@
+#include "phase_timer.h"
+
+#include <algorithm>
+#include <iomanip>
+
+thread_local PhaseTimes* thread_phase_times = nullptr;
+
+const char* phase_name(Phase phase) {
+  switch (phase) {
+    case PHASE_READ: return "read";
+    case PHASE_PARSE: return "parse";
+    case PHASE_BOUNDARY: return "boundary";
+    case PHASE_CANONICAL: return "canonical";
+    case PHASE_TRANSFORM_BANK: return "transform_bank";
+    case PHASE_MIRROR_FACTORS: return "mirror_factors";
+    case PHASE_GAPPED_MIRROR_FACTORS: return "gapped_mirror_factors";
+    case PHASE_ROTADROME_FACTORS: return "rotadrome_factors";
+    case PHASE_REFLECT_SQUARE_FACTORS: return "reflect_square_factors";
+    case PHASE_GAPPED_REFLECT_SQUARE_FACTORS: return "gapped_reflect_square_factors";
+    case PHASE_TRANSLATION: return "translation";
+    case PHASE_HALF_TURN: return "half_turn";
+    case PHASE_QUARTER_TURN: return "quarter_turn";
+    case PHASE_TYPE_1_REFLECTION: return "type_1_reflection";
+    case PHASE_TYPE_2_REFLECTION: return "type_2_reflection";
+    case PHASE_TYPE_1_HALF_TURN_REFLECTION: return "type_1_half_turn_reflection";
+    case PHASE_TYPE_2_HALF_TURN_REFLECTION: return "type_2_half_turn_reflection";
+    case PHASE_CASE_7: return "case_7";
+    case PHASE_CASE_8A: return "case_8a";
+    case PHASE_CASE_8B: return "case_8b";
+    case NUM_PHASES: break;
+  }
+  return "unknown";
+}
+
+void print_phase_table(std::ostream& out, const PhaseTimes& times, uint64_t wall_ns, size_t num_threads) {
+  double thread_ns = double(wall_ns) * std::max<size_t>(num_threads, 1);
+  std::ios_base::fmtflags flags = out.flags();
+  char fill = out.fill(' ');
+  std::streamsize precision = out.precision();
+  out << std::left << std::setw(30) << "Phase" << std::right
+      << std::setw(12) << "Calls" << std::setw(14) << "Total ms"
+      << std::setw(12) << "ns/call" << std::setw(11) << "Thread %" << "\n";
+  out << std::fixed;
+  for (int p = 0; p < NUM_PHASES; ++p) {
+    if (times.calls[p] == 0) {
+      continue;
+    }
+    out << std::left << std::setw(30) << phase_name(Phase(p)) << std::right
+        << std::setw(12) << times.calls[p]
+        << std::setw(14) << std::setprecision(3) << times.ns[p] / 1e6
+        << std::setw(12) << std::setprecision(0) << double(times.ns[p]) / times.calls[p]
+        << std::setw(11) << std::setprecision(1) << (wall_ns ? 100.0 * times.ns[p] / thread_ns : 0.0)
+        << "\n";
+  }
+  out.flags(flags);
+  out.fill(fill);
+  out.precision(precision);
+}
+
+void print_phase_json(std::ostream& out, const PhaseTimes& times, uint64_t wall_ns, size_t num_threads) {
+  out << "{\"wall_ns\": " << wall_ns << ", \"threads\": " << num_threads << ", \"phases\": {";
+  bool first = true;
+  for (int p = 0; p < NUM_PHASES; ++p) {
+    if (times.calls[p] == 0) {
+      continue;
+    }
+    out << (first ? "" : ", ") << "\"" << phase_name(Phase(p)) << "\": {\"calls\": "
+        << times.calls[p] << ", \"ns\": " << times.ns[p] << "}";
+    first = false;
+  }
+  out << "}}\n";
+}
@@ -0,0 +1,107 @@
+#ifndef PHASE_TIMER_H
+#define PHASE_TIMER_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+// Parts of a run that can be timed separately.
+enum Phase {
+  PHASE_READ,
+  PHASE_PARSE,
+  PHASE_BOUNDARY,
+  PHASE_CANONICAL,
+  PHASE_TRANSFORM_BANK,
+  PHASE_MIRROR_FACTORS,
+  PHASE_GAPPED_MIRROR_FACTORS,
+  PHASE_ROTADROME_FACTORS,
+  PHASE_REFLECT_SQUARE_FACTORS,
+  PHASE_GAPPED_REFLECT_SQUARE_FACTORS,
+  PHASE_TRANSLATION,
+  PHASE_HALF_TURN,
+  PHASE_QUARTER_TURN,
+  PHASE_TYPE_1_REFLECTION,
+  PHASE_TYPE_2_REFLECTION,
+  PHASE_TYPE_1_HALF_TURN_REFLECTION,
+  PHASE_TYPE_2_HALF_TURN_REFLECTION,
+  PHASE_CASE_7,
+  PHASE_CASE_8A,
+  PHASE_CASE_8B,
+  NUM_PHASES
+};
+
+const char* phase_name(Phase phase);
+
+// Time spent and number of entries per phase. Aligned so that the
+// counters of different threads never share a cache line.
+struct alignas(64) PhaseTimes {
+  uint64_t ns[NUM_PHASES] = {};
+  uint64_t calls[NUM_PHASES] = {};
+
+  PhaseTimes& operator+=(const PhaseTimes& other) {
+    for (int p = 0; p < NUM_PHASES; ++p) {
+      ns[p] += other.ns[p];
+      calls[p] += other.calls[p];
+    }
+    return *this;
+  }
+};
+
+#ifdef POLYISO_LIBRARY
+
+// libpolyiso keeps no global state, so its phases are never timed and
+// the rest of this header is left out.
+class ScopedPhase {
+ public:
+  explicit ScopedPhase(Phase) {}
+  ScopedPhase(const ScopedPhase&) = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+};
+
+#else
+
+// The counters of the calling thread, or null when timing is off. Each
+// thread points this at its own PhaseTimes, so recording never shares a
+// cache line, and the driver adds them up at the end.
+extern thread_local PhaseTimes* thread_phase_times;
+
+// Adds the time until the end of the scope to a phase of the calling
+// thread's counters. Costs one thread-local load when timing is off.
+// Phases nest, e.g. gapped reflect square factors inside the type 2
+// reflection cases, and each reports its inclusive time.
+class ScopedPhase {
+ public:
+  explicit ScopedPhase(Phase phase) : times_(thread_phase_times), phase_(phase) {
+    if (times_) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  ~ScopedPhase() {
+    if (times_) {
+      auto elapsed = std::chrono::steady_clock::now() - start_;
+      times_->ns[phase_] += std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+      ++times_->calls[phase_];
+    }
+  }
+
+  ScopedPhase(const ScopedPhase&) = delete;
+  ScopedPhase& operator=(const ScopedPhase&) = delete;
+
+ private:
+  PhaseTimes* times_;
+  Phase phase_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Writes the phases that were entered as an aligned table, or as a JSON
+// object keyed by phase name. The table's share column divides each
+// phase's time, summed over threads, by wall_ns times the number of timed
+// threads, so it is the phase's share of all the time the threads had.
+void print_phase_table(std::ostream& out, const PhaseTimes& times, uint64_t wall_ns, size_t num_threads);
+void print_phase_json(std::ostream& out, const PhaseTimes& times, uint64_t wall_ns, size_t num_threads);
+
+#endif  // POLYISO_LIBRARY
+
+#endif // PHASE_TIMER_H
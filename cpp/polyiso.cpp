@@ -0,0 +1,179 @@
+#include "polyiso.h"
+
+#include "boundary.h"
+#include "isohedral.h"
+
+#include <algorithm>
+#include <vector>
+
+static_assert(POLYISO_MAX_LETTERS == MAX_BND, "POLYISO_MAX_LETTERS must match the checker");
+
+struct polyiso_checker {
+  GridType grid;
+  IsohedralChecker checker;
+};
+
+namespace {
+
+// Traces the boundary of a polyform into word. Returns the result the
+// polyform gets without checking, or POLYISO_ISOHEDRAL if word is to be
+// checked.
+template <typename grid>
+int trace(const int32_t* cells, size_t num_cells, boundaryword& word) {
+  Shape<grid> shape;
+  for (size_t i = 0; i < num_cells; ++i) {
+    shape.add(cells[2 * i], cells[2 * i + 1]);
+  }
+  TracedBoundary<grid> boundary;
+  if (num_cells == 0 || !traceBoundary(shape, boundary)) {
+    return POLYISO_NOT_SIMPLE;
+  }
+  if (boundary.word.size() > POLYISO_MAX_LETTERS) {
+    return POLYISO_TOO_LONG;
+  }
+  word = std::move(boundary.word);
+  return POLYISO_ISOHEDRAL;
+}
+
+int trace(GridType grid, const int32_t* cells, size_t num_cells, boundaryword& word) {
+  switch (grid) {
+    case HEX:
+      return trace<HexGrid<int>>(cells, num_cells, word);
+    case IAMOND:
+      return trace<IamondGrid<int>>(cells, num_cells, word);
+    case KITE:
+      return trace<KiteGrid<int>>(cells, num_cells, word);
+    default:
+      return trace<OminoGrid<int>>(cells, num_cells, word);
+  }
+}
+
+// Whether word, of the given length, is a boundary word: it is made of
+// edges of the grid, returns to its start without passing through a
+// vertex twice, and runs clockwise, so its signed area is negative.
+bool is_boundary_word(const int32_t* word, size_t length,
+                      const std::vector<std::pair<int, int>>& grid_letters) {
+  if (length == 0) {
+    return false;
+  }
+  std::vector<std::pair<long, long>> vertices{{0, 0}};
+  long area = 0;
+  for (size_t k = 0; k < length; ++k) {
+    if (!std::binary_search(grid_letters.begin(), grid_letters.end(),
+                            std::pair<int, int>(word[2 * k], word[2 * k + 1]))) {
+      return false;
+    }
+    long x = vertices.back().first;
+    long y = vertices.back().second;
+    std::pair<long, long> next(x + word[2 * k], y + word[2 * k + 1]);
+    area += x * next.second - next.first * y;
+    if (k + 1 < length && std::find(vertices.begin(), vertices.end(), next) != vertices.end()) {
+      return false;
+    }
+    vertices.push_back(next);
+  }
+  return vertices.back() == vertices.front() && area < 0;
+}
+
+// Sets all num_results results to POLYISO_ERROR and returns it, for a
+// batch whose check failed.
+int fail_batch(size_t num_results, int8_t* results) {
+  std::fill(results, results + num_results, int8_t(POLYISO_ERROR));
+  return POLYISO_ERROR;
+}
+
+// Checks the words whose results are still POLYISO_ISOHEDRAL, which
+// marks them as pending.
+void check_pending(const IsohedralChecker& checker, std::vector<boundaryword>& words,
+                   size_t num_results, int8_t* results) {
+  std::vector<bool> checked = checker.check_batch(words);
+  size_t w = 0;
+  for (size_t i = 0; i < num_results; ++i) {
+    if (results[i] == POLYISO_ISOHEDRAL) {
+      results[i] = checked[w++] ? POLYISO_ISOHEDRAL : POLYISO_NOT_ISOHEDRAL;
+    }
+  }
+}
+
+}  // namespace
+
+// No exception may cross the C interface, so each entry point catches
+// them and reports a failure instead.
+
+polyiso_checker* polyiso_create(int grid) {
+  if (grid < OMINO || grid > KITE) {
+    return nullptr;
+  }
+  try {
+    return new polyiso_checker{GridType(grid), IsohedralChecker::forGrid(GridType(grid))};
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void polyiso_destroy(polyiso_checker* checker) {
+  delete checker;
+}
+
+int polyiso_check(const polyiso_checker* checker, const int32_t* cells, size_t num_cells) {
+  try {
+    boundaryword word;
+    int result = trace(checker->grid, cells, num_cells, word);
+    if (result != POLYISO_ISOHEDRAL) {
+      return result;
+    }
+    return checker->checker.has_isohedral_tiling(word) ? POLYISO_ISOHEDRAL : POLYISO_NOT_ISOHEDRAL;
+  } catch (...) {
+    return POLYISO_ERROR;
+  }
+}
+
+int polyiso_check_batch(const polyiso_checker* checker, const int32_t* cells, const size_t* counts,
+                        size_t num_polyforms, int8_t* results) {
+  try {
+    std::vector<boundaryword> words;
+    words.reserve(num_polyforms);
+    boundaryword word;
+    for (size_t i = 0; i < num_polyforms; ++i) {
+      results[i] = int8_t(trace(checker->grid, cells, counts[i], word));
+      if (results[i] == POLYISO_ISOHEDRAL) {
+        words.push_back(word);
+      }
+      cells += 2 * counts[i];
+    }
+    check_pending(checker->checker, words, num_polyforms, results);
+    return 0;
+  } catch (...) {
+    return fail_batch(num_polyforms, results);
+  }
+}
+
+int polyiso_check_words(const polyiso_checker* checker, const int32_t* letters, const size_t* lengths,
+                        size_t num_words, int8_t* results) {
+  try {
+    std::vector<boundaryword> words;
+    words.reserve(num_words);
+    const std::vector<std::pair<int, int>>& grid_letters = checker->checker.letter_tables().letters;
+    for (size_t i = 0; i < num_words; ++i) {
+      const int32_t* word = letters;
+      letters += 2 * lengths[i];
+      if (lengths[i] > POLYISO_MAX_LETTERS) {
+        results[i] = POLYISO_TOO_LONG;
+        continue;
+      }
+      if (!is_boundary_word(word, lengths[i], grid_letters)) {
+        results[i] = POLYISO_NOT_SIMPLE;
+        continue;
+      }
+      results[i] = POLYISO_ISOHEDRAL;
+      words.emplace_back();
+      for (size_t k = 0; k < lengths[i]; ++k) {
+        words.back().push_back({word[2 * k], word[2 * k + 1]});
+      }
+    }
+    check_pending(checker->checker, words, num_words, results);
+    return 0;
+  } catch (...) {
+    return fail_batch(num_words, results);
+  }
+}
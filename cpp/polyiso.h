@@ -0,0 +1,115 @@
+#ifndef POLYISO_H
+#define POLYISO_H
+
+// libpolyiso: the isohedral checker as a library, for programs that check
+// polyforms in process instead of running isohedral_e2e.
+//
+// Every call works on buffers owned by the caller and reports results
+// through them; nothing is printed and nothing outlives the call but the
+// checker itself. A checker holds only the tables of its grid, never
+// changes after it is created, and may be used by several threads at
+// once. The C++ interface at the end is a thin wrapper over the C one.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// The library is built with hidden visibility; only these calls are
+// exported.
+#if defined(__GNUC__)
+#define POLYISO_API __attribute__((visibility("default")))
+#else
+#define POLYISO_API
+#endif
+
+// Grids, as in heesch-sat.
+enum {
+  POLYISO_OMINO = 0,
+  POLYISO_HEX = 1,
+  POLYISO_IAMOND = 2,
+  POLYISO_KITE = 3
+};
+
+// The result for one polyform or boundary word.
+enum {
+  POLYISO_NOT_ISOHEDRAL = 0,
+  POLYISO_ISOHEDRAL = 1,
+  // The boundary isn't a simple closed curve: the cells have a hole,
+  // aren't connected, or two of them meet only at a vertex, or a word is
+  // empty, has a letter that isn't an edge of the grid, doesn't return to
+  // its start, passes through a vertex twice or runs counterclockwise.
+  POLYISO_NOT_SIMPLE = -1,
+  // The boundary has more than POLYISO_MAX_LETTERS letters.
+  POLYISO_TOO_LONG = -2,
+  // The check failed, such as when memory ran out.
+  POLYISO_ERROR = -3
+};
+
+// Longest boundary word the checker handles.
+#define POLYISO_MAX_LETTERS 50
+
+typedef struct polyiso_checker polyiso_checker;
+
+// Returns a checker for the grid, or NULL for an unknown grid or when the
+// checker can't be created.
+POLYISO_API polyiso_checker* polyiso_create(int grid);
+POLYISO_API void polyiso_destroy(polyiso_checker* checker);
+
+// Checks the polyform whose num_cells cells have the coordinates
+// cells[2 * i], cells[2 * i + 1], as in heesch-sat's gen output.
+POLYISO_API int polyiso_check(const polyiso_checker* checker, const int32_t* cells, size_t num_cells);
+
+// Checks num_polyforms polyforms whose cells are stored back to back in
+// cells, polyform i having counts[i] cells, and writes one result per
+// polyform to results. The words are checked together, which is faster
+// than checking them one at a time. Returns 0, or POLYISO_ERROR if the
+// check failed, in which case every result is POLYISO_ERROR.
+POLYISO_API int polyiso_check_batch(const polyiso_checker* checker, const int32_t* cells, const size_t* counts,
+                                    size_t num_polyforms, int8_t* results);
+
+// Checks num_words boundary words whose letters are stored back to back
+// in letters as x, y pairs, word i having lengths[i] letters, and writes
+// one result per word to results. Letters are the edge vectors of the
+// grid that isohedral_e2e extracts from a polyform, listed clockwise.
+// Returns 0 or POLYISO_ERROR, as polyiso_check_batch does.
+POLYISO_API int polyiso_check_words(const polyiso_checker* checker, const int32_t* letters, const size_t* lengths,
+                                    size_t num_words, int8_t* results);
+
+#ifdef __cplusplus
+}  // extern "C"
+
+namespace polyiso {
+
+class Checker {
+ public:
+  explicit Checker(int grid) : checker_(polyiso_create(grid)) {}
+  Checker(const Checker&) = delete;
+  Checker& operator=(const Checker&) = delete;
+  ~Checker() { polyiso_destroy(checker_); }
+
+  // False if the grid is unknown.
+  bool valid() const { return checker_ != nullptr; }
+
+  int check(const int32_t* cells, size_t num_cells) const {
+    return polyiso_check(checker_, cells, num_cells);
+  }
+
+  int check_batch(const int32_t* cells, const size_t* counts, size_t num_polyforms, int8_t* results) const {
+    return polyiso_check_batch(checker_, cells, counts, num_polyforms, results);
+  }
+
+  int check_words(const int32_t* letters, const size_t* lengths, size_t num_words, int8_t* results) const {
+    return polyiso_check_words(checker_, letters, lengths, num_words, results);
+  }
+
+ private:
+  polyiso_checker* checker_;
+};
+
+}  // namespace polyiso
+#endif  // __cplusplus
+
+#endif // POLYISO_H
@@ -0,0 +1,103 @@
+#include "polyiso.h"
+
+#include <stdio.h>
+
+/* Checks polyforms through the C interface of libpolyiso. */
+
+static int expect(const char* name, const int8_t* results, const int8_t* expected, size_t n) {
+  for (size_t i = 0; i < n; ++i) {
+    if (results[i] != expected[i]) {
+      printf("%s test failed at %zu: got %d, expected %d.\n", name, i, results[i], expected[i]);
+      return 0;
+    }
+  }
+  printf("%s test case passed.\n", name);
+  return 1;
+}
+
+int main(void) {
+  polyiso_checker* omino = polyiso_create(POLYISO_OMINO);
+  polyiso_checker* hex = polyiso_create(POLYISO_HEX);
+  if (!omino || !hex || polyiso_create(7) != NULL) {
+    printf("Checker creation test failed.\n");
+    return 0;
+  }
+
+  /* A domino, an octomino that doesn't tile isohedrally, a ring with a
+     hole, two cells meeting at a corner, and an empty polyform. */
+  const int32_t cells[] = {
+    0, 0, 1, 0,
+    0, 0, 0, 1, 0, 2, 0, 3, 0, 4, 1, 0, 1, 3, 2, 0,
+    0, 0, 1, 0, 2, 0, 0, 1, 2, 1, 0, 2, 1, 2, 2, 2,
+    0, 0, 1, 1
+  };
+  const size_t counts[] = {2, 8, 8, 2, 0};
+  const int8_t expected_cells[] = {
+    POLYISO_ISOHEDRAL, POLYISO_NOT_ISOHEDRAL, POLYISO_NOT_SIMPLE, POLYISO_NOT_SIMPLE, POLYISO_NOT_SIMPLE
+  };
+  int8_t results[5];
+  polyiso_check_batch(omino, cells, counts, 5, results);
+  expect("Omino batch", results, expected_cells, 5);
+
+  int8_t single[2] = {
+    (int8_t)polyiso_check(omino, cells, 2),
+    (int8_t)polyiso_check(omino, cells + 4, 8)
+  };
+  expect("Omino single", single, expected_cells, 2);
+
+  /* A hexagon of the hex grid. */
+  const int32_t hexagon[] = {0, 0};
+  int8_t hex_result = (int8_t)polyiso_check(hex, hexagon, 1);
+  int8_t hex_expected = POLYISO_ISOHEDRAL;
+  expect("Hex single", &hex_result, &hex_expected, 1);
+
+  /* The unit square, a path that doesn't close, a letter that isn't an
+     omino edge, and a word that is too long. */
+  int32_t letters[2 * (4 + 2 + 4 + 2 * 26)];
+  const int32_t prefix[] = {
+    0, 1, 1, 0, 0, -1, -1, 0,
+    0, 1, 1, 0,
+    0, 2, 1, 0, 0, -2, -1, 0
+  };
+  size_t n = 0;
+  for (; n < sizeof(prefix) / sizeof(prefix[0]); ++n) {
+    letters[n] = prefix[n];
+  }
+  for (int k = 0; k < 26; ++k, n += 2) {
+    letters[n] = 1;
+    letters[n + 1] = 0;
+  }
+  for (int k = 0; k < 26; ++k, n += 2) {
+    letters[n] = -1;
+    letters[n + 1] = 0;
+  }
+  const size_t lengths[] = {4, 2, 4, 52};
+  const int8_t expected_words[] = {
+    POLYISO_ISOHEDRAL, POLYISO_NOT_SIMPLE, POLYISO_NOT_SIMPLE, POLYISO_TOO_LONG
+  };
+  if (polyiso_check_words(omino, letters, lengths, 4, results) != 0) {
+    printf("Omino words test failed: the check reported an error.\n");
+    return 0;
+  }
+  expect("Omino words", results, expected_words, 4);
+
+  /* Closed words that aren't boundaries: a step and its inverse, a
+     domino's outline traced back along itself, two squares meeting at a
+     vertex, and the unit square counterclockwise. */
+  const int32_t degenerate[] = {
+    1, 0, -1, 0,
+    1, 0, 1, 0, -1, 0, -1, 0,
+    0, 1, 1, 0, 0, -1, 1, 0, 0, -1, -1, 0, 0, 1, -1, 0,
+    1, 0, 0, 1, -1, 0, 0, -1
+  };
+  const size_t degenerate_lengths[] = {2, 4, 8, 4};
+  const int8_t expected_degenerate[] = {
+    POLYISO_NOT_SIMPLE, POLYISO_NOT_SIMPLE, POLYISO_NOT_SIMPLE, POLYISO_NOT_SIMPLE
+  };
+  polyiso_check_words(omino, degenerate, degenerate_lengths, 4, results);
+  expect("Degenerate words", results, expected_degenerate, 4);
+
+  polyiso_destroy(omino);
+  polyiso_destroy(hex);
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include "progress.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+// Formats a number of seconds as HH:MM:SS.
+std::string format_duration(double seconds) {
+  size_t total = static_cast<size_t>(seconds + 0.5);
+  std::ostringstream out;
+  out << std::setfill('0') << std::setw(2) << total / 3600 << ":"
+      << std::setw(2) << total / 60 % 60 << ":" << std::setw(2) << total % 60;
+  return out.str();
+}
+
+}  // namespace
+
+ProgressReporter::ProgressReporter(size_t num_workers, double interval_seconds, std::ostream& out)
+    : num_workers_(num_workers), interval_seconds_(interval_seconds), out_(out),
+      slots_(new WorkerProgress[num_workers + 1]), start_(std::chrono::steady_clock::now()) {
+  thread_ = std::thread([this]() { run(); });
+}
+
+ProgressReporter::~ProgressReporter() {
+  stop();
+}
+
+void ProgressReporter::stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void ProgressReporter::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  auto interval = std::chrono::duration<double>(interval_seconds_);
+  auto last = start_;
+  size_t last_words = 0;
+  while (!wake_.wait_for(lock, interval, [this]() { return stopping_; })) {
+    auto now = std::chrono::steady_clock::now();
+    report(std::chrono::duration<double>(now - start_).count(),
+           std::chrono::duration<double>(now - last).count(), last_words);
+    last = now;
+  }
+}
+
+void ProgressReporter::report(double elapsed, double since_last, size_t& last_words) {
+  size_t words = 0;
+  size_t isohedral = 0;
+  size_t units = 0;
+  size_t max_worker_words = 0;
+  size_t worker_words = 0;
+  for (size_t slot = 0; slot <= num_workers_; ++slot) {
+    size_t slot_words = slots_[slot].words.load(std::memory_order_relaxed);
+    words += slot_words;
+    isohedral += slots_[slot].isohedral.load(std::memory_order_relaxed);
+    units += slots_[slot].units.load(std::memory_order_relaxed);
+    if (slot < num_workers_) {
+      worker_words += slot_words;
+      max_worker_words = std::max(max_worker_words, slot_words);
+    }
+  }
+
+  std::ostringstream line;
+  line << std::fixed << std::setprecision(1) << "Progress: " << words << " words, "
+       << std::setprecision(0) << (words - last_words) / since_last << " words/s";
+  last_words = words;
+  size_t total_units = total_units_.load(std::memory_order_relaxed);
+  if (total_units > 0) {
+    line << std::setprecision(1) << ", " << 100.0 * std::min(units, total_units) / total_units << "%";
+    if (units > 0) {
+      double remaining = elapsed * (total_units - std::min(units, total_units)) / units;
+      line << ", ETA " << format_duration(remaining);
+    }
+  }
+  if (words > 0) {
+    line << std::setprecision(1) << ", isohedral " << 100.0 * isohedral / words << "%";
+  }
+  if (worker_words > 0) {
+    line << std::setprecision(2) << ", imbalance "
+         << double(max_worker_words) * num_workers_ / worker_words;
+  }
+  out_ << line.str() << "\n" << std::flush;
+}
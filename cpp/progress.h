@@ -0,0 +1,78 @@
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <thread>
+
+// The counts of one thread. Aligned so that the counters of different
+// threads never share a cache line.
+struct alignas(64) WorkerProgress {
+  std::atomic<size_t> words{0};
+  std::atomic<size_t> isohedral{0};
+  // Units of work done, such as bytes of a mapped input or subtrees of an
+  // enumeration, for the percentage and ETA.
+  std::atomic<size_t> units{0};
+};
+
+// Prints the progress of a run from its own thread at a fixed interval:
+// words checked per second, percent done and estimated time left (when
+// the total amount of work is known), the fraction of isohedral words,
+// and the imbalance between checker threads as the largest word count
+// over the mean.
+//
+// Every thread owns one slot of counters, which only it writes, so an
+// update is a relaxed load and store with no read-modify-write or lock.
+// The reporting thread reads them with relaxed loads; a report may be a
+// little behind, but never blocks a worker.
+class ProgressReporter {
+ public:
+  // Slots 0 to num_workers - 1 belong to the checker threads, and one
+  // more to the driving thread, which is left out of the imbalance.
+  ProgressReporter(size_t num_workers, double interval_seconds, std::ostream& out);
+  ProgressReporter(const ProgressReporter&) = delete;
+  ProgressReporter& operator=(const ProgressReporter&) = delete;
+  ~ProgressReporter();
+
+  // The number of units in the whole run, or 0 if unknown.
+  void set_total_units(size_t total) {
+    total_units_.store(total, std::memory_order_relaxed);
+  }
+
+  // Adds to the counters of a slot. Must only be called by the slot's
+  // own thread.
+  void add(size_t slot, size_t words, size_t isohedral, size_t units) {
+    WorkerProgress& progress = slots_[slot];
+    progress.words.store(progress.words.load(std::memory_order_relaxed) + words,
+                         std::memory_order_relaxed);
+    progress.isohedral.store(progress.isohedral.load(std::memory_order_relaxed) + isohedral,
+                             std::memory_order_relaxed);
+    progress.units.store(progress.units.load(std::memory_order_relaxed) + units,
+                         std::memory_order_relaxed);
+  }
+
+  // Stops the reporting thread without a last report.
+  void stop();
+
+ private:
+  void run();
+  void report(double elapsed, double since_last, size_t& last_words);
+
+  const size_t num_workers_;
+  const double interval_seconds_;
+  std::ostream& out_;
+  std::unique_ptr<WorkerProgress[]> slots_;
+  std::atomic<size_t> total_units_{0};
+  const std::chrono::steady_clock::time_point start_;
+  std::mutex mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+  std::thread thread_;
+};
+
+#endif // PROGRESS_H
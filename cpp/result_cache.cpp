@@ -0,0 +1,178 @@
+#include "result_cache.h"
+
+#include <cstring>
+#include <mutex>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'P', 'O', 'L', 'Y', 'I', 'S', 'O', 'C'};
+const uint32_t FORMAT_VERSION = 1;
+
+struct Header {
+  char magic[8];
+  uint32_t format_version;
+  int32_t grid;
+};
+
+// Flush once this many records are pending.
+const size_t FLUSH_THRESHOLD = 4096;
+
+bool write_all(int fd, const void* data, size_t size) {
+  const char* p = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t written = ::write(fd, p, size);
+    if (written < 0) {
+      return false;
+    }
+    p += written;
+    size -= written;
+  }
+  return true;
+}
+
+}  // namespace
+
+uint64_t boundary_fingerprint(const boundaryword& word) {
+  // FNV-1a over the letters, finished with the splitmix64 mixer.
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (auto& c: word) {
+    h ^= point<int>(c.first, c.second).pack();
+    h *= 0x100000001b3ULL;
+  }
+  h ^= word.size();
+  return hash_mix(h);
+}
+
+ResultCache::~ResultCache() {
+  close();
+}
+
+bool ResultCache::open(const std::string& path, GridType grid, uint16_t version) {
+  close();
+  int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (fd == -1) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    ::close(fd);
+    return false;
+  }
+
+  size_t size = st.st_size;
+  if (size == 0) {
+    Header header;
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.format_version = FORMAT_VERSION;
+    header.grid = grid;
+    if (!write_all(fd, &header, sizeof(header))) {
+      ::close(fd);
+      return false;
+    }
+    size = sizeof(header);
+  } else {
+    if (size < sizeof(Header)) {
+      ::close(fd);
+      return false;
+    }
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      ::close(fd);
+      return false;
+    }
+    const Header* header = static_cast<const Header*>(map);
+    if (memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header->format_version != FORMAT_VERSION || header->grid != grid) {
+      munmap(map, size);
+      ::close(fd);
+      return false;
+    }
+    // A torn final record from an interrupted run is ignored.
+    size_t num_records = (size - sizeof(Header)) / sizeof(Record);
+    const Record* records = reinterpret_cast<const Record*>(header + 1);
+    madvise(map, size, MADV_SEQUENTIAL);
+    index_.reserve(num_records);
+    for (size_t i = 0; i < num_records; ++i) {
+      const Record& r = records[i];
+      if (r.version == version) {
+        index_[index_key(r.key, Kind(r.kind))] = r.result;
+      }
+    }
+    munmap(map, size);
+    // Drop a torn tail so new records stay aligned.
+    size_t aligned = sizeof(Header) + num_records * sizeof(Record);
+    if (aligned != size && ftruncate(fd, aligned) != 0) {
+      ::close(fd);
+      return false;
+    }
+  }
+
+  fd_ = fd;
+  failed_ = false;
+  version_ = version;
+  loaded_ = index_.size();
+  return true;
+}
+
+bool ResultCache::close() {
+  if (fd_ == -1) {
+    return true;
+  }
+  bool ok = flush();
+  if (::close(fd_) != 0) {
+    ok = false;
+  }
+  fd_ = -1;
+  index_.clear();
+  pending_.clear();
+  loaded_ = 0;
+  return ok;
+}
+
+bool ResultCache::find(uint64_t key, Kind kind, uint32_t& result) const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  auto it = index_.find(index_key(key, kind));
+  if (it == index_.end()) {
+    return false;
+  }
+  result = it->second;
+  return true;
+}
+
+void ResultCache::insert(uint64_t key, Kind kind, uint32_t result) {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  if (!index_.emplace(index_key(key, kind), result).second) {
+    return;
+  }
+  pending_.push_back({key, result, version_, kind});
+  if (pending_.size() >= FLUSH_THRESHOLD) {
+    // A failure is kept in failed_ and reported by flush() or close().
+    flush_locked();
+  }
+}
+
+bool ResultCache::flush() {
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  return flush_locked();
+}
+
+bool ResultCache::flush_locked() {
+  if (fd_ == -1 || pending_.empty() || failed_) {
+    pending_.clear();
+    return !failed_;
+  }
+  size_t bytes = pending_.size() * sizeof(Record);
+  bool ok = write_all(fd_, pending_.data(), bytes);
+  pending_.clear();
+  if (!ok) {
+    // Nothing more is appended after a partly written record, which open
+    // drops as a torn tail, so the file stays readable.
+    failed_ = true;
+  }
+  return ok;
+}
@@ -0,0 +1,82 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "boundary.h"
+#include "common.h"
+
+#include <cstdint>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Returns a 64-bit fingerprint of a boundary word. Unlike
+// BoundaryWordHash this is part of the cache file format and must never
+// change.
+uint64_t boundary_fingerprint(const boundaryword& word);
+
+// A persistent, append-only cache of checker results.
+//
+// The file is a 16 byte header (magic, format version, grid type)
+// followed by fixed size records in host byte order. Existing records are
+// read through a memory map when the cache is opened. New results are
+// buffered and appended on flush() or close(). Records written by another
+// checker version are ignored, so a checker change only costs a
+// recomputation. Keys are fingerprints of canonical words, so distinct
+// words could in principle collide; with 64-bit keys that is unlikely
+// below billions of entries.
+class ResultCache {
+ public:
+  struct Record {
+    uint64_t key;
+    uint32_t result;
+    uint16_t version;
+    uint16_t kind;
+  };
+
+  // Record kinds. The result of an isohedral check is 1 or 0.
+  enum Kind : uint16_t {
+    ISOHEDRAL = 0
+  };
+
+  ResultCache() = default;
+  ResultCache(const ResultCache&) = delete;
+  ResultCache& operator=(const ResultCache&) = delete;
+  ~ResultCache();
+
+  // Opens or creates the cache file at path for the given grid. Returns
+  // false if the file cannot be opened or belongs to another grid.
+  bool open(const std::string& path, GridType grid, uint16_t version);
+  // Flushes and closes the file. Returns false if any write since open
+  // failed.
+  bool close();
+  bool is_open() const { return fd_ != -1; }
+
+  // Thread-safe. Returns true and fills result on a hit.
+  bool find(uint64_t key, Kind kind, uint32_t& result) const;
+  void insert(uint64_t key, Kind kind, uint32_t result);
+
+  // Appends buffered records to the file. Once a write fails, including
+  // one made by insert, nothing more is written and this returns false
+  // until the cache is closed.
+  bool flush();
+
+  // Number of usable records loaded from the file when it was opened.
+  size_t loaded() const { return loaded_; }
+
+ private:
+  static uint64_t index_key(uint64_t key, Kind kind) {
+    return hash_combine(key, kind);
+  }
+  bool flush_locked();
+
+  int fd_ = -1;
+  bool failed_ = false;
+  uint16_t version_ = 0;
+  size_t loaded_ = 0;
+  mutable std::shared_mutex mutex_;
+  std::unordered_map<uint64_t, uint32_t> index_;
+  std::vector<Record> pending_;
+};
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,54 @@
+#ifndef RESULT_MEMO_H
+#define RESULT_MEMO_H
+
+#include "boundary.h"
+
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+// A concurrent map from canonical boundary words to checker results.
+//
+// The table is split into independently locked shards picked by the word
+// hash, so workers rarely wait on each other for a lookup.
+template <typename V, size_t NUM_SHARDS = 64>
+class ResultMemo {
+ public:
+  // Returns true and fills result if word has been seen before.
+  bool find(const boundaryword& word, V& result) const {
+    size_t h = BoundaryWordHash()(word);
+    const Shard& shard = shards_[h % NUM_SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.map.find(word);
+    if (it == shard.map.end()) {
+      return false;
+    }
+    result = it->second;
+    return true;
+  }
+
+  void insert(const boundaryword& word, const V& result) {
+    size_t h = BoundaryWordHash()(word);
+    Shard& shard = shards_[h % NUM_SHARDS];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.map.emplace(word, result);
+  }
+
+  size_t size() const {
+    size_t total = 0;
+    for (const Shard& shard: shards_) {
+      std::lock_guard<std::mutex> lock(shard.mutex);
+      total += shard.map.size();
+    }
+    return total;
+  }
+
+ private:
+  struct Shard {
+    mutable std::mutex mutex;
+    std::unordered_map<boundaryword, V, BoundaryWordHash> map;
+  };
+  std::array<Shard, NUM_SHARDS> shards_;
+};
+
+#endif // RESULT_MEMO_H
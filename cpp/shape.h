@@ -1,7 +1,9 @@
 #ifndef SHAPE_H
 #define SHAPE_H
 
-#include <list>
+#include <algorithm>
+#include <iterator>
+#include <vector>
 
 template<typename grid>
 class Shape
@@ -46,7 +48,7 @@ public:
 
 	void complete()
 	{
-		pts_.sort();
+		std::sort( pts_.begin(), pts_.end() );
 	}
 
 	Shape& operator =( const Shape& other ) 
@@ -61,6 +63,8 @@ public:
 		return *this;
 	}
 
+	// Empties the shape but keeps its storage, so a shape can be reused
+	// as a buffer without reallocating.
 	void reset()
 	{
 		pts_.clear();
@@ -208,7 +212,7 @@ public:
 	void debug() const;
 
 private:
-	std::list<point_t> pts_;
+	std::vector<point_t> pts_;
 };
 
 #endif // SHAPE_H
@@ -0,0 +1,155 @@
+#include "word_file.h"
+#include "isohedral.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+const char MAGIC[8] = {'P', 'O', 'L', 'Y', 'I', 'S', 'O', 'W'};
+const uint32_t FORMAT_VERSION = 2;
+
+size_t padded(size_t size) {
+  return (size + 3) & ~size_t(3);
+}
+
+bool write_all(int fd, const void* data, size_t size) {
+  const char* p = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t written = ::write(fd, p, size);
+    if (written < 0) {
+      return false;
+    }
+    p += written;
+    size -= written;
+  }
+  return true;
+}
+
+}  // namespace
+
+bool is_word_file(const char* begin, const char* end) {
+  return size_t(end - begin) >= sizeof(MAGIC) && memcmp(begin, MAGIC, sizeof(MAGIC)) == 0;
+}
+
+bool index_word_file(const char* begin, const char* end, GridType grid,
+                     std::vector<const char*>& blocks, WordFileHeader& header, std::string& error) {
+  if (size_t(end - begin) < sizeof(header)) {
+    error = "Word file is truncated";
+    return false;
+  }
+  memcpy(&header, begin, sizeof(header));
+  if (memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.format_version != FORMAT_VERSION) {
+    error = "Unsupported word file version";
+    return false;
+  }
+  if (header.grid != grid) {
+    error = "Word file belongs to another grid";
+    return false;
+  }
+
+  blocks.clear();
+  size_t num_words = 0;
+  const char* p = begin + sizeof(header);
+  for (uint64_t b = 0; b < header.num_blocks; ++b) {
+    uint32_t count = 0;
+    uint32_t num_letters = 0;
+    size_t available = end - p;
+    if (available >= sizeof(count)) {
+      memcpy(&count, p, sizeof(count));
+    }
+    size_t letters_start = sizeof(count) * (size_t(count) + 2);
+    if (available >= letters_start) {
+      memcpy(&num_letters, p + letters_start - sizeof(num_letters), sizeof(num_letters));
+    }
+    size_t size = padded(letters_start + num_letters);
+    if (available < sizeof(count) || available < letters_start || available < size) {
+      error = "Word file is truncated";
+      return false;
+    }
+    // The offsets start at 0 and never decrease, and each word fits the
+    // checker. The last offset is the letter count the block size was
+    // taken from, so every word lies inside the block.
+    uint32_t previous = 0;
+    for (uint32_t k = 0; k <= count; ++k) {
+      uint32_t offset;
+      memcpy(&offset, p + sizeof(count) * (size_t(k) + 1), sizeof(offset));
+      if (k == 0 ? offset != 0 : offset < previous || !fits_checker(offset - previous)) {
+        error = "Word file has a malformed block";
+        return false;
+      }
+      previous = offset;
+    }
+    blocks.push_back(p);
+    num_words += count;
+    p += size;
+  }
+  if (num_words != header.num_words || header.num_polyforms < num_words) {
+    error = "Word file has the wrong number of words";
+    return false;
+  }
+  return true;
+}
+
+void read_word_block(const char* block, BoundaryCorpus& corpus) {
+  uint32_t count;
+  memcpy(&count, block, sizeof(count));
+  // The header and every block are a multiple of 4 bytes long, so the
+  // offsets are aligned in the mapping.
+  const uint32_t* offsets = reinterpret_cast<const uint32_t*>(block + sizeof(count));
+  const uint8_t* letters = reinterpret_cast<const uint8_t*>(offsets + count + 1);
+  corpus.assign(offsets, count, letters);
+}
+
+WordFileWriter::~WordFileWriter() {
+  close();
+}
+
+bool WordFileWriter::open(const std::string& path, GridType grid) {
+  fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd_ == -1) {
+    return false;
+  }
+  memcpy(header_.magic, MAGIC, sizeof(MAGIC));
+  header_.format_version = FORMAT_VERSION;
+  header_.grid = grid;
+  // The counts are filled in by close().
+  failed_ = !write_all(fd_, &header_, sizeof(header_));
+  return true;
+}
+
+bool WordFileWriter::write_block(const BoundaryCorpus& corpus) {
+  uint32_t count = uint32_t(corpus.size());
+  size_t num_letters = corpus.num_letters();
+  static const char zeros[4] = {};
+  size_t header_size = sizeof(count) * (count + 2);
+  bool ok = write_all(fd_, &count, sizeof(count)) &&
+            write_all(fd_, corpus.offset_data(), sizeof(uint32_t) * (count + 1)) &&
+            write_all(fd_, corpus.letter_data(), num_letters) &&
+            write_all(fd_, zeros, padded(header_size + num_letters) - header_size - num_letters);
+  header_.num_words += count;
+  ++header_.num_blocks;
+  failed_ = failed_ || !ok;
+  return ok;
+}
+
+void WordFileWriter::set_input_counts(uint64_t num_polyforms, uint64_t num_not_simple,
+                                      uint64_t num_unchecked) {
+  header_.num_polyforms = num_polyforms;
+  header_.num_not_simple = num_not_simple;
+  header_.num_unchecked = num_unchecked;
+}
+
+bool WordFileWriter::close() {
+  if (fd_ == -1) {
+    return !failed_;
+  }
+  if (pwrite(fd_, &header_, sizeof(header_), 0) != ssize_t(sizeof(header_))) {
+    failed_ = true;
+  }
+  failed_ = ::close(fd_) != 0 || failed_;
+  fd_ = -1;
+  return !failed_;
+}
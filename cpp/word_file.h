@@ -0,0 +1,92 @@
+#ifndef WORD_FILE_H
+#define WORD_FILE_H
+
+#include "boundary_corpus.h"
+#include "common.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A binary file of pre-extracted boundary words, which the checker reads
+// through a memory map with no text parsing or boundary tracing.
+//
+// The file is a 56 byte header followed by blocks of words, all in host
+// byte order. The header holds:
+//
+//   char magic[8]         "POLYISOW"
+//   uint32_t version      format version, currently 2
+//   int32_t grid          the GridType of the words
+//   uint64_t words        number of words in the file
+//   uint64_t blocks       number of blocks
+//   uint64_t polyforms    number of polyforms in the input
+//   uint64_t not_simple   polyforms left out as their boundary isn't simple
+//   uint64_t unchecked    lines left out as they couldn't be parsed or
+//                         traced, or their boundary is too long to check
+//
+// The last three are the counts a run on the text input would report,
+// so a run on the word file reports the same ones.
+//
+// Each block holds:
+//
+//   uint32_t words              number of words n in the block
+//   uint32_t offsets[n + 1]     start of each word in letters, from 0
+//   uint8_t letters[offsets[n]] letters packed as in BoundaryCorpus
+//
+// padded with zeros to a multiple of 4 bytes. A block has the layout of
+// a BoundaryCorpus, so it is loaded with two copies.
+struct WordFileHeader {
+  char magic[8];
+  uint32_t format_version;
+  int32_t grid;
+  uint64_t num_words;
+  uint64_t num_blocks;
+  uint64_t num_polyforms;
+  uint64_t num_not_simple;
+  uint64_t num_unchecked;
+};
+
+// Returns true if [begin, end) starts with the word file magic.
+bool is_word_file(const char* begin, const char* end);
+
+// Checks the header of a word file in memory against the grid, copies it
+// to header, finds the start of every block and validates the offsets of
+// its words. Returns false and sets error if the file belongs to another
+// grid or is malformed. The file must start at a 4 byte aligned address.
+bool index_word_file(const char* begin, const char* end, GridType grid,
+                     std::vector<const char*>& blocks, WordFileHeader& header, std::string& error);
+
+// Loads the words of the block at block into corpus. block must be one
+// that index_word_file found and validated.
+void read_word_block(const char* block, BoundaryCorpus& corpus);
+
+// Writes a word file one block at a time.
+class WordFileWriter {
+ public:
+  WordFileWriter() = default;
+  WordFileWriter(const WordFileWriter&) = delete;
+  WordFileWriter& operator=(const WordFileWriter&) = delete;
+  ~WordFileWriter();
+
+  // Creates or truncates the file at path. Returns false if it cannot be
+  // opened.
+  bool open(const std::string& path, GridType grid);
+
+  // Appends the words of corpus as one block.
+  bool write_block(const BoundaryCorpus& corpus);
+
+  // Sets the counts of the input that the words were taken from.
+  void set_input_counts(uint64_t num_polyforms, uint64_t num_not_simple, uint64_t num_unchecked);
+
+  // Fills in the counts of the header and closes the file. Returns false
+  // if any write failed.
+  bool close();
+
+ private:
+  int fd_ = -1;
+  bool failed_ = false;
+  WordFileHeader header_ = {};
+};
+
+#endif // WORD_FILE_H
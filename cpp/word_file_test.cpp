@@ -0,0 +1,143 @@
+#include "word_file.h"
+#include "isohedral.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace std;
+
+// A straight bar of n cells' worth of letters around an omino, which is
+// 2n + 2 letters long.
+boundaryword bar(int n) {
+  boundaryword word;
+  for (int i = 0; i < n; ++i) {
+    word.push_back({1, 0});
+  }
+  word.push_back({0, -1});
+  for (int i = 0; i < n; ++i) {
+    word.push_back({-1, 0});
+  }
+  word.push_back({0, 1});
+  return word;
+}
+
+// Writes the blocks to a word file and returns its contents, stored
+// 4 byte aligned as index_word_file requires.
+vector<uint32_t> writeWords(const vector<BoundaryCorpus>& blocks, uint64_t num_polyforms, size_t& size) {
+  char path[] = "/tmp/word_file_testXXXXXX";
+  int fd = mkstemp(path);
+  close(fd);
+  WordFileWriter writer;
+  bool ok = writer.open(path, OMINO);
+  for (const BoundaryCorpus& block: blocks) {
+    ok = ok && writer.write_block(block);
+  }
+  writer.set_input_counts(num_polyforms, 1, 2);
+  ok = writer.close() && ok;
+  ifstream in(path, ios::binary);
+  string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+  unlink(path);
+  size = ok ? data.size() : 0;
+  vector<uint32_t> words((data.size() + 3) / 4);
+  memcpy(words.data(), data.data(), data.size());
+  return words;
+}
+
+bool indexes(const vector<uint32_t>& file, size_t size, vector<const char*>& blocks,
+             WordFileHeader& header, string& error) {
+  const char* begin = reinterpret_cast<const char*>(file.data());
+  return index_word_file(begin, begin + size, OMINO, blocks, header, error);
+}
+
+// Returns true if index_word_file refuses file after corrupt changes it.
+template<typename Corrupt>
+bool refuses(vector<uint32_t> file, size_t size, Corrupt corrupt) {
+  corrupt(file, size);
+  vector<const char*> blocks;
+  WordFileHeader header;
+  string error;
+  return !indexes(file, size, blocks, header, error) && !error.empty();
+}
+
+// Stores value at byte offset at of file.
+void put(vector<uint32_t>& file, size_t at, uint32_t value) {
+  memcpy(reinterpret_cast<char*>(file.data()) + at, &value, sizeof(value));
+}
+
+int main() {
+  vector<BoundaryCorpus> corpora(3);
+  corpora[0].push_back(bar(1));
+  corpora[0].push_back(bar(3));
+  corpora[0].push_back(bar(2));
+  // An empty block, and one with the longest word the checker takes.
+  corpora[2].push_back(bar((MAX_BND - 2) / 2));
+  size_t size;
+  vector<uint32_t> file = writeWords(corpora, 7, size);
+
+  // The words read back unchanged, with the header counts.
+  bool roundTripOk = size > 0;
+  {
+    vector<const char*> blocks;
+    WordFileHeader header;
+    string error;
+    const char* begin = reinterpret_cast<const char*>(file.data());
+    roundTripOk = roundTripOk && is_word_file(begin, begin + size) &&
+                  indexes(file, size, blocks, header, error) && blocks.size() == corpora.size() &&
+                  header.num_words == 4 && header.num_polyforms == 7 && header.num_not_simple == 1 &&
+                  header.num_unchecked == 2;
+    for (size_t b = 0; roundTripOk && b < blocks.size(); ++b) {
+      BoundaryCorpus corpus;
+      read_word_block(blocks[b], corpus);
+      roundTripOk = corpus.size() == corpora[b].size();
+      for (size_t i = 0; roundTripOk && i < corpus.size(); ++i) {
+        roundTripOk = corpus.word(i) == corpora[b].word(i);
+      }
+    }
+  }
+  if (roundTripOk) {
+    cout << "Word file round trip test case passed.\n";
+  } else {
+    cout << "Word file round trip test failed.\n";
+  }
+
+  // Malformed files are refused. The first block starts after the 56
+  // byte header, with its offsets from byte 60.
+  const size_t OFFSETS = sizeof(WordFileHeader) + 4;
+  bool malformedOk = roundTripOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t&) { put(f, OFFSETS, 1); }) &&
+                malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t&) { put(f, OFFSETS + 8, 3); }) &&
+                malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t&) { put(f, OFFSETS - 4, 1000); }) &&
+                malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t& s) { s -= 4; }) && malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t& s) { s = 40; }) && malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t&) { put(f, 0, 0); }) && malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t&) { put(f, 8, 1); }) && malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t&) { put(f, 12, HEX); }) && malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t&) { put(f, 16, 5); }) && malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t&) { put(f, 24, 4); }) && malformedOk;
+  malformedOk = refuses(file, size, [](vector<uint32_t>& f, size_t&) { put(f, 32, 3); }) && malformedOk;
+  {
+    // A word longer than the checker takes.
+    vector<BoundaryCorpus> tooLong(1);
+    tooLong[0].push_back(bar(1));
+    tooLong[0].push_back(bar(MAX_BND / 2));
+    size_t tooLongSize;
+    vector<uint32_t> tooLongFile = writeWords(tooLong, 2, tooLongSize);
+    malformedOk = tooLongSize > 0 && refuses(tooLongFile, tooLongSize, [](vector<uint32_t>&, size_t&) {}) &&
+                  malformedOk;
+  }
+  if (malformedOk) {
+    cout << "Malformed word file test case passed.\n";
+  } else {
+    cout << "Malformed word file test failed.\n";
+  }
+}
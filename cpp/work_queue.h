@@ -0,0 +1,270 @@
+#ifndef WORK_QUEUE_H
+#define WORK_QUEUE_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+constexpr size_t CACHE_LINE = 64;
+
+// A bounded multi-producer multi-consumer queue (Vyukov's ring of
+// sequenced cells). try_push and try_pop are lock-free; push and pop
+// block on a condition variable while the queue is full or empty, which
+// keeps the producer from running arbitrarily far ahead of the consumers
+// without spinning. The mutex is only taken when a thread is waiting.
+template <typename T>
+class BoundedQueue {
+ public:
+  // Capacity is rounded up to a power of two.
+  explicit BoundedQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+      size *= 2;
+    }
+    mask_ = size - 1;
+    cells_.reset(new Cell[size]);
+    for (size_t i = 0; i < size; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  bool try_push(T& value) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[pos & mask_];
+      size_t seq = cell.sequence.load(std::memory_order_acquire);
+      if (seq == pos) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          cell.data = std::move(value);
+          cell.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (seq < pos) {
+        return false;  // Full.
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  bool try_pop(T& value) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    while (true) {
+      Cell& cell = cells_[pos & mask_];
+      size_t seq = cell.sequence.load(std::memory_order_acquire);
+      if (seq == pos + 1) {
+        if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          value = std::move(cell.data);
+          cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (seq < pos + 1) {
+        return false;  // Empty.
+      } else {
+        pos = dequeue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void push(T value) {
+    if (!try_push(value)) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      push_waiters_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      not_full_.wait(lock, [&] { return try_push(value); });
+      push_waiters_.fetch_sub(1);
+    }
+    wake(not_empty_, pop_waiters_);
+  }
+
+  // Waits for an element. Returns false once the queue is closed and
+  // drained.
+  bool pop(T& value) {
+    bool popped = try_pop(value);
+    if (!popped) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      pop_waiters_.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      not_empty_.wait(lock, [&] {
+        popped = try_pop(value);
+        return popped || closed_.load(std::memory_order_acquire);
+      });
+      pop_waiters_.fetch_sub(1);
+    }
+    if (!popped && !(popped = try_pop(value))) {
+      return false;
+    }
+    wake(not_full_, push_waiters_);
+    return true;
+  }
+
+  // Signals that no more elements will be pushed.
+  void close() {
+    closed_.store(true, std::memory_order_release);
+    std::lock_guard<std::mutex> lock(mutex_);
+    not_empty_.notify_all();
+  }
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+
+  std::unique_ptr<Cell[]> cells_;
+  size_t mask_;
+  alignas(CACHE_LINE) std::atomic<size_t> enqueue_pos_{0};
+  alignas(CACHE_LINE) std::atomic<size_t> dequeue_pos_{0};
+  alignas(CACHE_LINE) std::atomic<bool> closed_{false};
+  std::atomic<int> push_waiters_{0};
+  std::atomic<int> pop_waiters_{0};
+  std::mutex mutex_;
+  std::condition_variable not_full_;
+  std::condition_variable not_empty_;
+
+  // Called after a successful push or pop. A waiter registers itself under
+  // the mutex before re-checking the ring, and the fences order that
+  // against the cell update here, so either the waiter sees the change or
+  // it is counted here and woken.
+  void wake(std::condition_variable& cv, std::atomic<int>& waiters) {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiters.load(std::memory_order_relaxed) > 0) {
+      std::lock_guard<std::mutex> lock(mutex_);
+      cv.notify_one();
+    }
+  }
+};
+
+// Runs a fixed set of numbered tasks on a group of threads with range
+// stealing. Each worker starts with an equal contiguous block of task
+// indices and takes tasks from the front of its own block. When its block
+// is empty it steals the back half of the largest remaining block of
+// another worker, so work moves to idle threads in shrinking pieces until
+// the very end of the run.
+class WorkStealingPool {
+ public:
+  explicit WorkStealingPool(size_t num_threads)
+      : num_threads_(std::max<size_t>(1, num_threads)) {}
+
+  size_t num_threads() const { return num_threads_; }
+
+  // Calls fn(task, worker) exactly once for every task in [0, num_tasks),
+  // where worker < num_threads() identifies the calling thread. Returns
+  // when all tasks are done.
+  template <typename F>
+  void run(size_t num_tasks, F&& fn) {
+    std::unique_ptr<Range[]> ranges(new Range[num_threads_]);
+    for (size_t w = 0; w < num_threads_; ++w) {
+      ranges[w].store(num_tasks * w / num_threads_, num_tasks * (w + 1) / num_threads_);
+    }
+
+    auto work = [&](size_t worker) {
+      Range& own = ranges[worker];
+      while (true) {
+        uint32_t task;
+        while (own.pop_front(task)) {
+          fn(size_t(task), worker);
+        }
+        if (!steal(ranges.get(), worker)) {
+          return;
+        }
+      }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t w = 1; w < num_threads_; ++w) {
+      threads.emplace_back(work, w);
+    }
+    work(0);
+    for (auto& thread: threads) {
+      thread.join();
+    }
+  }
+
+ private:
+  // A block [lo, hi) of task indices packed into one atomic word, so the
+  // owner and thieves agree on it with a single compare-and-swap.
+  struct alignas(CACHE_LINE) Range {
+    std::atomic<uint64_t> bounds{0};
+
+    static uint64_t pack(uint32_t lo, uint32_t hi) {
+      return (uint64_t(hi) << 32) | lo;
+    }
+
+    void store(size_t lo, size_t hi) {
+      bounds.store(pack(uint32_t(lo), uint32_t(hi)), std::memory_order_release);
+    }
+
+    size_t remaining() const {
+      uint64_t b = bounds.load(std::memory_order_relaxed);
+      uint32_t lo = uint32_t(b), hi = uint32_t(b >> 32);
+      return hi > lo ? hi - lo : 0;
+    }
+
+    bool pop_front(uint32_t& task) {
+      uint64_t b = bounds.load(std::memory_order_acquire);
+      while (true) {
+        uint32_t lo = uint32_t(b), hi = uint32_t(b >> 32);
+        if (lo >= hi) {
+          return false;
+        }
+        if (bounds.compare_exchange_weak(b, pack(lo + 1, hi), std::memory_order_acq_rel)) {
+          task = lo;
+          return true;
+        }
+      }
+    }
+
+    // Takes the back half (rounded up) of the block.
+    bool steal_back(uint32_t& first, uint32_t& last) {
+      uint64_t b = bounds.load(std::memory_order_acquire);
+      while (true) {
+        uint32_t lo = uint32_t(b), hi = uint32_t(b >> 32);
+        if (lo >= hi) {
+          return false;
+        }
+        uint32_t mid = hi - (hi - lo + 1) / 2;
+        if (bounds.compare_exchange_weak(b, pack(lo, mid), std::memory_order_acq_rel)) {
+          first = mid;
+          last = hi;
+          return true;
+        }
+      }
+    }
+  };
+
+  // Refills the empty block of thief from the fullest other block.
+  // Returns false once no work is left anywhere.
+  bool steal(Range* ranges, size_t thief) {
+    while (true) {
+      size_t victim = num_threads_;
+      size_t most = 0;
+      for (size_t w = 0; w < num_threads_; ++w) {
+        size_t r = ranges[w].remaining();
+        if (w != thief && r > most) {
+          most = r;
+          victim = w;
+        }
+      }
+      if (victim == num_threads_) {
+        return false;
+      }
+      uint32_t first, last;
+      if (ranges[victim].steal_back(first, last)) {
+        ranges[thief].store(first, last);
+        return true;
+      }
+    }
+  }
+
+  size_t num_threads_;
+};
+
+#endif // WORK_QUEUE_H